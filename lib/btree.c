@@ -28,6 +28,9 @@
 
 #include <string.h>
 #include <sys/types.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif /* __AVX2__ */
 
 /* Local headers */
 
@@ -44,6 +47,39 @@
 #define __C_BTREE_UNDERFLOW 3
 #define __C_BTREE_NOTFOUND 4
 
+#define __C_BTREE_ALIGN 64
+
+/* The node header is padded so that the keys which follow it are aligned
+   for vector loads. On LP64 platforms the header itself is 32 bytes, so
+   the first four keys share its cache line. */
+
+#define __C_BTREE_HEADER_SIZE                                           \
+  ((sizeof(c_btree_node_t) + 31) & ~(size_t)31)
+
+#define __C_btree_node_size_n(N)                                        \
+  (__C_BTREE_HEADER_SIZE + ((N) * (sizeof(c_id_t) + sizeof(void *)))    \
+   + (((N) + 1) * sizeof(c_btree_node_t *)))
+
+#define __C_btree_node_size(T)                  \
+  __C_btree_node_size_n((T)->nkeys)
+
+/* Nodes with at most this many keys are searched linearly with vector
+   compares, rather than by binary search. */
+
+#define __C_BTREE_LINEAR_MAX 64
+
+/* Keys and values are stored in parallel arrays; these move a datum in
+   and out of a node. */
+
+#define __C_btree_get(N, I, D)                                  \
+  ((D).key = (N)->keys[(I)], (D).value = (N)->values[(I)])
+
+#define __C_btree_put(N, I, D)                                  \
+  ((N)->keys[(I)] = (D).key, (N)->values[(I)] = (D).value)
+
+#define __C_btree_copy(N, I, M, J)                              \
+  ((N)->keys[(I)] = (M)->keys[(J)], (N)->values[(I)] = (M)->values[(J)])
+
 /* Functions */
 
 c_btree_t *C_btree_create(uint_t order)
@@ -67,10 +103,28 @@ c_btree_t *C_btree_create(uint_t order)
 
 static c_btree_node_t *__C_btree_create_node(c_btree_t *tree)
 {
-  c_btree_node_t *node = C_new(c_btree_node_t);
+  c_btree_node_t *node;
+  char *p;
+
+  /* The node header is followed, in the same allocation, by the keys,
+     the values, and the child pointers, each stored contiguously. The
+     allocation is aligned on a cache line, so that the header and the
+     first few keys share a line, and a search within the node touches
+     as few lines as possible. */
+
+  if(tree->slab)
+    p = (char *)C_slab_alloc(tree->slab);
+  else
+    p = (char *)C_mem_manage_aligned(__C_btree_node_size(tree),
+                                     __C_BTREE_ALIGN, TRUE);
 
-  node->keys = C_newa(tree->nkeys, c_datum_t);
-  node->children = C_newa((tree->nkeys + 1), c_btree_node_t *);
+  node = (c_btree_node_t *)p;
+  p += __C_BTREE_HEADER_SIZE;
+  node->keys = (c_id_t *)p;
+  p += tree->nkeys * sizeof(c_id_t);
+  node->values = (void **)p;
+  p += tree->nkeys * sizeof(void *);
+  node->children = (c_btree_node_t **)p;
 
   return(node);
 }
@@ -80,9 +134,10 @@ static c_btree_node_t *__C_btree_create_node(c_btree_t *tree)
 
 static void __C_btree_destroy_node(c_btree_t *tree, c_btree_node_t *node)
 {
-  C_free(node->keys);
-  C_free(node->children);
-  C_free(node);
+  if(tree->slab)
+    C_slab_free(tree->slab, node);
+  else
+    C_free(node);
 }
 
 /*
@@ -92,9 +147,21 @@ static void __C_btree_destroy_recursive(c_btree_t *tree, c_btree_node_t *node)
 {
   int j;
 
-  for(j = 0; j < node->count; ++j)
+  if(! node)
+    return;
+
+  for(j = 0; j <= node->count; ++j)
     __C_btree_destroy_recursive(tree, node->children[j]);
 
+  if(tree->destructor)
+  {
+    for(j = 0; j < node->count; ++j)
+    {
+      if(node->values[j])
+        tree->destructor(node->values[j]);
+    }
+  }
+
   __C_btree_destroy_node(tree, node);
 }
 
@@ -127,26 +194,142 @@ c_bool_t C_btree_set_destructor(c_btree_t *tree, void (*destructor)(void *))
 /*
  */
 
-static uint_t __C_btree_bsearch(c_id_t x, c_datum_t *a, uint_t len)
+c_bool_t C_btree_set_slab(c_btree_t *tree, c_slab_t *slab)
 {
-  uint_t mid, left = 0, right = len - 1;
+  if(!tree || tree->root)
+    return(FALSE);
 
-  if(x <= a[left].key)
-    return(0);
+  /* slab objects of a cache line or more are themselves line-aligned, so
+     nodes drawn from a slab keep the alignment of heap-allocated ones */
+
+  if(slab && (C_slab_objsize(slab) < __C_btree_node_size(tree)))
+    return(FALSE);
+
+  tree->slab = slab;
 
-  if(x > a[right].key)
-    return(len);
+  return(TRUE);
+}
+
+/*
+ */
+
+size_t C_btree_node_size(uint_t order)
+{
+  return(__C_btree_node_size_n(order * 2));
+}
 
-  while((right - left) > 1)
+/* Subtree counts are maintained only if they have been enabled for the
+   tree; otherwise, these cost nothing beyond the test. */
+
+static void __C_btree_recount(c_btree_t *tree, c_btree_node_t *node)
+{
+  uint_t total;
+  uint_t i;
+
+  if(! tree->counted)
+    return;
+
+  total = node->count;
+
+  if(node->children[0])
   {
-    mid = (right + left) / 2;
-    if(x <= a[mid].key)
-      right = mid;
-    else
-      left = mid;
+    for(i = 0; i <= node->count; ++i)
+      total += node->children[i]->total;
   }
 
-  return(right);
+  node->total = total;
+}
+
+/*
+ */
+
+static void __C_btree_recount_all(c_btree_t *tree, c_btree_node_t *node)
+{
+  uint_t i;
+
+  if(! node)
+    return;
+
+  if(node->children[0])
+  {
+    for(i = 0; i <= node->count; ++i)
+      __C_btree_recount_all(tree, node->children[i]);
+  }
+
+  __C_btree_recount(tree, node);
+}
+
+/*
+ */
+
+static uint_t __C_btree_bsearch(c_id_t x, const c_id_t *a, uint_t len)
+{
+  const c_id_t *base = a;
+  uint_t half;
+
+  /* Returns the index of the first key not less than x. */
+
+#ifdef __AVX2__
+
+  /* In smaller nodes, compare four keys at a time and count those less
+     than x; since the keys are sorted, that count is the index. AVX2 has
+     only a signed 64-bit comparison, so the sign bits are flipped first. */
+
+  if(len <= __C_BTREE_LINEAR_MAX)
+  {
+    const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i vx = _mm256_xor_si256(_mm256_set1_epi64x((long long)x),
+                                        bias);
+    uint_t i, n = 0;
+
+    for(i = 0; (i + 4) <= len; i += 4)
+    {
+      __m256i vk = _mm256_xor_si256(
+        _mm256_loadu_si256((const __m256i *)(a + i)), bias);
+
+      n += __builtin_popcount(
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(vx, vk))));
+    }
+
+    for(; i < len; ++i)
+      n += (a[i] < x);
+
+    return(n);
+  }
+
+#endif /* __AVX2__ */
+
+  /* Otherwise, a binary search whose only branch is the loop itself; the
+     comparison compiles to a conditional move, so there are no
+     mispredictions, and the loop runs a fixed number of times for a
+     given node size. */
+
+  if(len == 0)
+    return(0);
+
+  while(len > 1)
+  {
+    half = len >> 1;
+    base = (base[half] < x) ? (base + half) : base;
+    len -= half;
+  }
+
+  return((uint_t)(base - a) + (*base < x));
+}
+
+/*
+ */
+
+static void **__C_btree_locate(c_btree_node_t *node, c_id_t key)
+{
+  uint_t i;
+
+  i = __C_btree_bsearch(key, node->keys, node->count);
+
+  if((i < node->count) && (node->keys[i] == key))
+    return(&(node->values[i]));
+
+  return(NULL);
 }
 
 /*
@@ -154,12 +337,16 @@ static uint_t __C_btree_bsearch(c_id_t x, c_datum_t *a, uint_t len)
 
 static int __C_btree_insert_node(c_btree_t *tree, c_datum_t key,
                                  c_btree_node_t *node, c_datum_t *rkey,
-                                 c_btree_node_t **rnode)
+                                 c_btree_node_t **rnode, void ***where)
 {
   c_btree_node_t *newnode, *_node;
   c_datum_t newkey, _key;
   int i, j, s;
 
+  /* If 'where' is not NULL, it receives the final location of the value
+     for the given key, whether it was found or newly inserted. A datum
+     that floats up out of a split is tracked at the level above. */
+
   /* We're at a leaf, and can't go any deeper. This node will need to be
      split. */
 
@@ -174,11 +361,24 @@ static int __C_btree_insert_node(c_btree_t *tree, c_datum_t key,
      and try to store it in that subtree */
 
   i = __C_btree_bsearch(key.key, node->keys, node->count);
-  if((i < node->count) && (node->keys[i].key == key.key))
+  if((i < node->count) && (node->keys[i] == key.key))
+  {
+    if(where)
+      *where = &(node->values[i]);
+
     return(__C_BTREE_DUPLICATE);
+  }
 
   s = __C_btree_insert_node(tree, key, node->children[i], &newkey,
-                            &newnode);
+                            &newnode, where);
+
+  if(s == __C_BTREE_OK)
+  {
+    if(tree->counted)
+      ++node->total;
+
+    return(s);
+  }
 
   if(s != __C_BTREE_OVERFLOW)
     return(s);
@@ -194,15 +394,22 @@ static int __C_btree_insert_node(c_btree_t *tree, c_datum_t key,
 
     for(j = node->count; j > i; --j)
     {
-      node->keys[j] = node->keys[j - 1];
+      __C_btree_copy(node, j, node, j - 1);
       node->children[j + 1] = node->children[j];
     }
 
     /* insert new key */
 
-    node->keys[i] = newkey;
+    __C_btree_put(node, i, newkey);
     node->children[i + 1] = newnode;
     ++node->count;
+
+    if(where && (newkey.key == key.key))
+      *where = &(node->values[i]);
+
+    if(tree->counted)
+      ++node->total;
+
     return(__C_BTREE_OK);
   }
 
@@ -215,71 +422,129 @@ static int __C_btree_insert_node(c_btree_t *tree, c_datum_t key,
   }
   else
   {
-    _key = node->keys[tree->nkeys - 1];
+    __C_btree_get(node, tree->nkeys - 1, _key);
     _node = node->children[tree->nkeys];
 
     for(j = (tree->nkeys - 1); j > i; --j)
     {
-      node->keys[j] = node->keys[j - 1];
+      __C_btree_copy(node, j, node, j - 1);
       node->children[j + 1] = node->children[j];
     }
 
-    node->keys[i] = newkey;
+    __C_btree_put(node, i, newkey);
     node->children[i + 1] = newnode;
   }
 
   /* move right half of keys & child pointers into new node, and float
      middle item (excess) up to level above */
 
-  *rkey = node->keys[tree->order];
+  __C_btree_get(node, tree->order, *rkey);
   node->count = tree->order;
   *rnode = __C_btree_create_node(tree);
   (*rnode)->count = tree->order;
 
   for(j = 0; j < tree->order - 1; ++j)
   {
-    (*rnode)->keys[j] = node->keys[j + tree->order + 1];
+    __C_btree_copy(*rnode, j, node, j + tree->order + 1);
     (*rnode)->children[j] = node->children[j + tree->order + 1];
   }
 
-  (*rnode)->keys[tree->order - 1] = _key;
+  __C_btree_put(*rnode, tree->order - 1, _key);
   (*rnode)->children[tree->order - 1] = node->children[tree->nkeys];
   (*rnode)->children[tree->order] = _node;
 
+  __C_btree_recount(tree, node);
+  __C_btree_recount(tree, *rnode);
+
+  if(where && (newkey.key == key.key) && (rkey->key != key.key))
+  {
+    if(!(*where = __C_btree_locate(node, key.key)))
+      *where = __C_btree_locate(*rnode, key.key);
+  }
+
   return(__C_BTREE_OVERFLOW);
 }
 
 /*
  */
 
-c_bool_t C_btree_store(c_btree_t *tree, c_id_t key, const void *data)
+static int __C_btree_insert(c_btree_t *tree, c_id_t key, const void *data,
+                            void ***where)
 {
   c_btree_node_t *newnode, *n;
   c_datum_t newkey, ikey;
   int s;
 
-  if(!tree || (key == 0LL))
-    return(FALSE);
-
   ikey.key = key;
   ikey.value = (void *)data;
 
-  s = __C_btree_insert_node(tree, ikey, tree->root, &newkey, &newnode);
-  if(s == __C_BTREE_DUPLICATE)
-    return(FALSE);
+  s = __C_btree_insert_node(tree, ikey, tree->root, &newkey, &newnode, where);
 
   if(s == __C_BTREE_OVERFLOW)
   {
     n = __C_btree_create_node(tree);
     n->count = 1;
-    n->keys[0] = newkey;
+    __C_btree_put(n, 0, newkey);
     n->children[0] = tree->root;
     n->children[1] = newnode;
 
+    __C_btree_recount(tree, n);
     tree->root = n;
+
+    if(where && (newkey.key == key))
+      *where = &(n->values[0]);
   }
 
-  return(TRUE);
+  return(s);
+}
+
+/*
+ */
+
+c_bool_t C_btree_store(c_btree_t *tree, c_id_t key, const void *data)
+{
+  if(!tree || (key == 0LL))
+    return(FALSE);
+
+  return(__C_btree_insert(tree, key, data, NULL) != __C_BTREE_DUPLICATE);
+}
+
+/*
+ */
+
+void **C_btree_find_or_insert(c_btree_t *tree, c_id_t key, c_bool_t *inserted)
+{
+  void **where = NULL;
+  int s;
+
+  if(!tree || (key == 0LL))
+    return(NULL);
+
+  s = __C_btree_insert(tree, key, NULL, &where);
+
+  if(inserted)
+    *inserted = (s != __C_BTREE_DUPLICATE);
+
+  return(where);
+}
+
+/*
+ */
+
+void **C_btree_upsert(c_btree_t *tree, c_id_t key, const void *data)
+{
+  void **slot;
+  c_bool_t inserted;
+
+  if(!(slot = C_btree_find_or_insert(tree, key, &inserted)))
+    return(NULL);
+
+  if(!inserted && tree->destructor && *slot && (*slot != data))
+    tree->destructor(*slot);
+
+  *slot = (void *)data;
+
+  return(slot);
 }
 
 /*
@@ -291,7 +556,8 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
   c_bool_t borrowleft;
   int i, j, nq, s;
   c_btree_node_t *left, *right, *q, *q1;
-  c_datum_t tmp, *_key = NULL;
+  c_datum_t tmp;
+  int k;
 
   if(! node)
     return(__C_BTREE_NOTFOUND);
@@ -306,22 +572,24 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
   {
     /* is it actually in this node? */
 
-    if((i == node->count) || (node->keys[i].key > key))
+    if((i == node->count) || (node->keys[i] > key))
       return(__C_BTREE_NOTFOUND);
 
+    /* free datum here, before it is shifted out of the node */
+
+    if(tree->destructor && node->values[i])
+      tree->destructor(node->values[i]);
+
     /* shift remaining elements over */
 
     for(j = i + 1; j < node->count; ++j)
     {
-      node->keys[j - 1] = node->keys[j];
+      __C_btree_copy(node, j - 1, node, j);
       node->children[j] = node->children[j + 1];
     }
 
-    /* free datum here */
-
-    tree->destructor(node->keys[i].value);
-
     --node->count;
+    __C_btree_recount(tree, node);
 
     if(node->count >= ((node == tree->root) ? 1 : tree->order))
       return(__C_BTREE_OK);
@@ -335,10 +603,10 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
   /* *t is an interior node (not a leaf): */
 
-  _key = &(node->keys[i]);
+  k = i; /* index of the separating item in this node */
   left = node->children[i];
 
-  if((i < node->count) && (node->keys[i].key == key))
+  if((i < node->count) && (node->keys[i] == key))
   {
     /* key found in interior node. Go to left child
      * p[i], then follow a path all the way to a leaf, using rightmost
@@ -357,15 +625,24 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
     /* exchange k[i] with the rightmost item in leaf. This item is the largest
      * key that is less than the key we are deleting. */
 
-    tmp = q->keys[nq - 1];
-    q->keys[nq - 1] = node->keys[i];
-    node->keys[i] = tmp;
+    __C_btree_get(q, nq - 1, tmp);
+    __C_btree_copy(q, nq - 1, node, i);
+    __C_btree_put(node, i, tmp);
   }
 
   /* The key now resides in a leaf node, and we can delete it easily.
    */
 
   s = __C_btree_delete_node(tree, key, left);
+
+  if(s == __C_BTREE_OK)
+  {
+    if(tree->counted)
+      --node->total;
+
+    return(s);
+  }
+
   if(s != __C_BTREE_UNDERFLOW)
     return(s);
 
@@ -384,7 +661,7 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
   if(borrowleft) /* p[i] is rightmost pointer in *p */
   {
-    _key = &(node->keys[i - 1]); /* the item we are borrowing */
+    k = i - 1; /* the item we are borrowing */
 
     left = node->children[i - 1]; /* left sibling */
     right = node->children[i]; /* this node */
@@ -400,7 +677,7 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
     for(j = right->count; j > 0; --j)
     {
-      right->keys[j] = right->keys[j - 1];
+      __C_btree_copy(right, j, right, j - 1);
       right->children[j] = right->children[j - 1];
     }
 
@@ -408,25 +685,32 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
     /* leftmost item in this node becomes rightmost item from left sibling */
 
-    right->keys[0] = *_key;
+    __C_btree_copy(right, 0, node, k);
     right->children[0] = left->children[left->count];
 
-    *_key = left->keys[left->count - 1];
+    __C_btree_copy(node, k, left, left->count - 1);
 
     --left->count;
 
     if(left->count >= tree->order)
-      return(__C_BTREE_OK); /* enough children in left sibling; no merge
-                               necessary */
+    {
+      /* enough children in left sibling; no merge necessary */
+
+      __C_btree_recount(tree, left);
+      __C_btree_recount(tree, right);
+      __C_btree_recount(tree, node);
+
+      return(__C_BTREE_OK);
+    }
   }
 
   else if(right->count > tree->order) /* borrowing from right */
   {
     /* rightmost item in this node becomes leftmost item from right sibling */
 
-    left->keys[tree->order - 1] = *_key;
+    __C_btree_copy(left, tree->order - 1, node, k);
     left->children[tree->order] = right->children[0];
-    *_key = right->keys[0];
+    __C_btree_copy(node, k, right, 0);
 
     /* shift everything to the left one position in the right sibling */
 
@@ -435,22 +719,27 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
     for(j = 0; j < right->count; ++j)
     {
-      right->keys[j] = right->keys[j + 1];
+      __C_btree_copy(right, j, right, j + 1);
       right->children[j] = right->children[j + 1];
     }
 
     right->children[right->count] = right->children[right->count + 1];
+
+    __C_btree_recount(tree, left);
+    __C_btree_recount(tree, right);
+    __C_btree_recount(tree, node);
+
     return(__C_BTREE_OK);
   }
 
   /* merge */
 
-  left->keys[tree->order - 1] = *_key;
+  __C_btree_copy(left, tree->order - 1, node, k);
   left->children[tree->order] = right->children[0];
 
   for(j = 0; j < tree->order; ++j)
   {
-    left->keys[tree->order + j] = right->keys[j];
+    __C_btree_copy(left, tree->order + j, right, j);
     left->children[tree->order + j + 1] = right->children[j + 1];
   }
 
@@ -462,12 +751,15 @@ static int __C_btree_delete_node(c_btree_t *tree, c_id_t key,
 
   for(j = i + 1; j < node->count; ++j)
   {
-    node->keys[j - 1] = node->keys[j];
+    __C_btree_copy(node, j - 1, node, j);
     node->children[j] = node->children[j + 1];
   }
 
   --node->count;
 
+  __C_btree_recount(tree, left);
+  __C_btree_recount(tree, node);
+
   /* do we have underflow in the parent now? */
 
   if(node->count < ((node == tree->root) ? 1 : tree->order))
@@ -519,10 +811,10 @@ void * C_btree_restore(c_btree_t *tree, c_id_t key)
   while(node)
   {
     i = __C_btree_bsearch(key, node->keys, node->count);
-    if((i < node->count) && (node->keys[i].key == key))
+    if((i < node->count) && (node->keys[i] == key))
     {
       /* found it! */
-      return(node->keys[i].value);
+      return(node->values[i]);
     }
 
     node = node->children[i];
@@ -540,13 +832,14 @@ static c_bool_t __C_btree_iterate(c_btree_node_t *node,
 {
   int i;
 
+  if(! node)
+    return(TRUE);
+
   /* go through all elements in this node */
 
   for(i = 0; i < node->count; ++i)
   {
-    c_datum_t datum = node->keys[i];
-
-    if(! consumer(datum.value, hook))
+    if(! consumer(node->values[i], hook))
       return(FALSE);
   }
 
@@ -568,8 +861,515 @@ c_bool_t C_btree_iterate(c_btree_t *btree,
                          c_bool_t (*consumer)(void *elem, void *hook),
                          void *hook)
 {
+  if(!btree || !consumer)
+    return(FALSE);
 
   return(__C_btree_iterate(btree->root, consumer, hook));
 }
 
+/* Returns the number of nodes into which n items should be divided so
+   that each node holds about per items, with one item between each pair
+   of adjacent nodes left over to separate them at the level above; every
+   node but the root must hold between order and 2 * order items. */
+
+static size_t __C_btree_bulk_nodes(c_btree_t *tree, size_t n, uint_t per)
+{
+  size_t lo, nodes;
+
+  nodes = (n + 1) / (per + 1);
+  lo = (n + 1 + tree->nkeys) / (tree->nkeys + 1);
+
+  return(C_max(C_max(nodes, lo), 1));
+}
+
+/* Builds one level of the tree from the items, and the nodes of the
+   level below (or NULL for the leaves). Returns the new nodes, and the
+   separators which go up to the next level in place. */
+
+static c_btree_node_t **__C_btree_bulk_level(c_btree_t *tree,
+                                             c_datum_t *items, size_t n,
+                                             c_btree_node_t **below,
+                                             uint_t per, size_t *nnodes)
+{
+  c_btree_node_t **nodes, *node;
+  size_t count, extra, i, j, k, sep = 0;
+  uint_t c;
+
+  count = __C_btree_bulk_nodes(tree, n, per);
+  nodes = C_newa(count, c_btree_node_t *);
+
+  /* each node takes (n + 1) / count - 1 items, and the first few one
+     more, to spread the remainder evenly */
+
+  extra = (n + 1) % count;
+
+  for(i = 0, j = 0, k = 0; i < count; ++i)
+  {
+    node = nodes[i] = __C_btree_create_node(tree);
+    node->count = (int)(((n + 1) / count) - 1 + ((i < extra) ? 1 : 0));
+
+    for(c = 0; c < node->count; ++c)
+    {
+      __C_btree_put(node, c, items[j]);
+      ++j;
+      if(below)
+        node->children[c] = below[k++];
+    }
+
+    if(below)
+      node->children[c] = below[k++];
+
+    if(i < (count - 1))
+      items[sep++] = items[j++];
+  }
+
+  *nnodes = count;
+
+  return(nodes);
+}
+
+/*
+ */
+
+c_bool_t C_btree_bulk_load(c_btree_t *tree, const c_datum_t *data, size_t n,
+                           float fill)
+{
+  c_datum_t *items;
+  c_btree_node_t **nodes, **below = NULL;
+  size_t i, count;
+  uint_t per;
+
+  if(!tree || tree->root || (!data && n)
+     || (fill < C_BTREE_MIN_FILL) || (fill > 1.0))
+    return(FALSE);
+
+  /* the keys must be nonzero and strictly ascending */
+
+  for(i = 0; i < n; ++i)
+  {
+    if((data[i].key == 0LL) || (i && (data[i].key <= data[i - 1].key)))
+      return(FALSE);
+  }
+
+  if(!n)
+    return(TRUE);
+
+  per = (uint_t)((fill * tree->nkeys) + 0.5);
+  per = C_max(C_min(per, tree->nkeys), tree->order);
+
+  /* Build the leaves, then each level above from the separators left
+     over by the level below, until a level consists of a single node.
+     The separators are compacted into the front of the working copy of
+     the items as each level is built. */
+
+  items = C_newa(n, c_datum_t);
+  memcpy(items, data, n * sizeof(c_datum_t));
+
+  for(;;)
+  {
+    nodes = __C_btree_bulk_level(tree, items, n, below, per, &count);
+    C_free(below);
+
+    if(count == 1)
+      break;
+
+    below = nodes;
+    n = count - 1;
+  }
+
+  tree->root = nodes[0];
+  __C_btree_recount_all(tree, tree->root);
+
+  C_free(nodes);
+  C_free(items);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static c_bool_t __C_btree_cursor_check(c_btree_cursor_t *cursor)
+{
+  /* an element at or beyond the limit ends the scan */
+
+  if(cursor->limit && (C_btree_cursor_key(cursor) >= cursor->limit))
+  {
+    cursor->depth = -1;
+    return(FALSE);
+  }
+
+  return(TRUE);
+}
+
+/* Pushes the path from node down to its leftmost (or rightmost) leaf. */
+
+static void __C_btree_cursor_descend(c_btree_cursor_t *cursor,
+                                     c_btree_node_t *node, c_bool_t right)
+{
+  while(node)
+  {
+    ++cursor->depth;
+    cursor->node[cursor->depth] = node;
+    cursor->pos[cursor->depth] = right ? node->count : 0;
+
+    node = node->children[cursor->pos[cursor->depth]];
+  }
+
+  /* the rightmost element of a leaf is one to the left of its last
+     child pointer */
+
+  if(right)
+    --cursor->pos[cursor->depth];
+}
+
+/*
+ */
+
+void *C_btree_min(c_btree_t *tree, c_id_t *key)
+{
+  c_btree_node_t *node;
+
+  if(!tree || !tree->root)
+    return(NULL);
+
+  for(node = tree->root; node->children[0]; node = node->children[0])
+    ;
+
+  if(key)
+    *key = node->keys[0];
+
+  return(node->values[0]);
+}
+
+/*
+ */
+
+void *C_btree_max(c_btree_t *tree, c_id_t *key)
+{
+  c_btree_node_t *node;
+
+  if(!tree || !tree->root)
+    return(NULL);
+
+  for(node = tree->root; node->children[node->count];
+      node = node->children[node->count])
+    ;
+
+  if(key)
+    *key = node->keys[node->count - 1];
+
+  return(node->values[node->count - 1]);
+}
+
+/*
+ */
+
+c_bool_t C_btree_set_counted(c_btree_t *tree, c_bool_t counted)
+{
+  if(!tree)
+    return(FALSE);
+
+  /* counts are not maintained while disabled, so they must be rebuilt */
+
+  if(counted && ! tree->counted)
+  {
+    tree->counted = TRUE;
+    __C_btree_recount_all(tree, tree->root);
+  }
+
+  tree->counted = counted;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+size_t C_btree_rank(c_btree_t *tree, c_id_t key)
+{
+  c_btree_node_t *node;
+  size_t rank = 0;
+  uint_t i, j;
+
+  if(!tree || ! tree->counted)
+    return(0);
+
+  /* add up everything to the left of the search path */
+
+  for(node = tree->root; node; node = node->children[i])
+  {
+    i = __C_btree_bsearch(key, node->keys, node->count);
+    rank += i;
+
+    if(node->children[0])
+    {
+      for(j = 0; j < i; ++j)
+        rank += node->children[j]->total;
+    }
+
+    if((i < node->count) && (node->keys[i] == key))
+    {
+      if(node->children[i])
+        rank += node->children[i]->total;
+
+      break;
+    }
+  }
+
+  return(rank);
+}
+
+/*
+ */
+
+void *C_btree_select(c_btree_t *tree, size_t k, c_id_t *key)
+{
+  c_btree_node_t *node;
+  size_t n;
+  uint_t i;
+
+  if(key)
+    *key = 0;
+
+  if(!tree || ! tree->counted || ! tree->root || (k >= tree->root->total))
+    return(NULL);
+
+  /* skip over whole subtrees until the k'th element is reached */
+
+  for(node = tree->root; node; node = node->children[i])
+  {
+    for(i = 0; i < node->count; ++i)
+    {
+      n = node->children[i] ? node->children[i]->total : 0;
+
+      if(k < n)
+        break;
+
+      k -= n;
+
+      if(k == 0)
+      {
+        if(key)
+          *key = node->keys[i];
+
+        return(node->values[i]);
+      }
+
+      --k;
+    }
+  }
+
+  return(NULL);
+}
+
+/*
+ */
+
+size_t C_btree_count_range(c_btree_t *tree, c_id_t lo, c_id_t hi)
+{
+  size_t n;
+
+  if(!tree || ! tree->counted || ! tree->root)
+    return(0);
+
+  /* an upper bound of 0 means no bound, as with cursor limits */
+
+  n = hi ? C_btree_rank(tree, hi) : tree->root->total;
+
+  return(n - C_min(n, C_btree_rank(tree, lo)));
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_init(c_btree_t *tree, c_btree_cursor_t *cursor)
+{
+  if(!tree || !cursor)
+    return(FALSE);
+
+  cursor->tree = tree;
+  cursor->depth = -1;
+  cursor->limit = 0;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_set_limit(c_btree_cursor_t *cursor, c_id_t limit)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->limit = limit;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_first(c_btree_cursor_t *cursor)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->depth = -1;
+
+  if(!cursor->tree->root)
+    return(FALSE);
+
+  __C_btree_cursor_descend(cursor, cursor->tree->root, FALSE);
+
+  return(__C_btree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_last(c_btree_cursor_t *cursor)
+{
+  c_id_t limit;
+
+  if(!cursor)
+    return(FALSE);
+
+  cursor->depth = -1;
+
+  if(!cursor->tree->root)
+    return(FALSE);
+
+  /* with a limit, the last element is the one preceding it */
+
+  if((limit = cursor->limit) != 0)
+  {
+    cursor->limit = 0;
+
+    if(C_btree_cursor_seek(cursor, limit))
+    {
+      cursor->limit = limit;
+      return(C_btree_cursor_prev(cursor));
+    }
+
+    cursor->limit = limit;
+  }
+
+  __C_btree_cursor_descend(cursor, cursor->tree->root, TRUE);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_seek(c_btree_cursor_t *cursor, c_id_t key)
+{
+  c_btree_node_t *node;
+  uint_t i;
+
+  if(!cursor)
+    return(FALSE);
+
+  cursor->depth = -1;
+
+  /* Descend towards the key, recording at each level the index of the
+     child taken. The first element not less than the key is either
+     found on the way down, or is the first element to the right of the
+     path, at the level where the path last turned left. */
+
+  for(node = cursor->tree->root; node; node = node->children[i])
+  {
+    i = __C_btree_bsearch(key, node->keys, node->count);
+
+    ++cursor->depth;
+    cursor->node[cursor->depth] = node;
+    cursor->pos[cursor->depth] = i;
+
+    if((i < node->count) && (node->keys[i] == key))
+      return(__C_btree_cursor_check(cursor));
+  }
+
+  while(cursor->depth >= 0)
+  {
+    if(cursor->pos[cursor->depth] < cursor->node[cursor->depth]->count)
+      return(__C_btree_cursor_check(cursor));
+
+    --cursor->depth;
+  }
+
+  return(FALSE);
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_next(c_btree_cursor_t *cursor)
+{
+  c_btree_node_t *node;
+  int d;
+
+  if(!cursor || (cursor->depth < 0))
+    return(FALSE);
+
+  d = cursor->depth;
+  node = cursor->node[d];
+
+  /* the successor of an element in an interior node is the leftmost
+     element of the subtree to its right */
+
+  if(node->children[0])
+  {
+    ++cursor->pos[d];
+    __C_btree_cursor_descend(cursor, node->children[cursor->pos[d]], FALSE);
+
+    return(__C_btree_cursor_check(cursor));
+  }
+
+  /* otherwise it is the next element in this leaf, or the element of the
+     nearest ancestor whose left subtree we have just finished */
+
+  ++cursor->pos[d];
+
+  while(cursor->pos[cursor->depth] == cursor->node[cursor->depth]->count)
+  {
+    if(--cursor->depth < 0)
+      return(FALSE);
+  }
+
+  return(__C_btree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_btree_cursor_prev(c_btree_cursor_t *cursor)
+{
+  c_btree_node_t *node;
+  int d;
+
+  if(!cursor || (cursor->depth < 0))
+    return(FALSE);
+
+  d = cursor->depth;
+  node = cursor->node[d];
+
+  if(node->children[0])
+  {
+    __C_btree_cursor_descend(cursor, node->children[cursor->pos[d]], TRUE);
+    return(TRUE);
+  }
+
+  while(cursor->pos[cursor->depth] == 0)
+  {
+    if(--cursor->depth < 0)
+      return(FALSE);
+  }
+
+  --cursor->pos[cursor->depth];
+
+  return(TRUE);
+}
+
 /* end of source file */
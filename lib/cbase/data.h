@@ -27,6 +27,8 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <inttypes.h>
+
 #include <cbase/defs.h>
 
 /* ----------------------------------------------------------------------------
@@ -52,6 +54,7 @@ extern "C" {
     c_link_t *p;
     size_t size;
     void (*destructor)(void *);
+    struct c_slab_t *slab;
   } c_linklist_t;
 
 #define C_linklist_head(L) ((L)->head)
@@ -63,6 +66,8 @@ extern "C" {
 
   extern c_bool_t C_linklist_set_destructor(c_linklist_t *l,
                                             void (*destructor)(void *));
+  extern c_bool_t C_linklist_set_slab(c_linklist_t *l,
+                                      struct c_slab_t *slab);
 
   extern c_bool_t C_linklist_store(c_linklist_t *l, const void *data);
 
@@ -136,6 +141,8 @@ extern "C" {
 
 #define C_stack_set_destructor(S, D)            \
   C_linklist_set_destructor((S), (D))
+#define C_stack_set_slab(S, A)                  \
+  C_linklist_set_slab((S), (A))
 
   extern void *C_linklist_pop(c_linklist_t *l);
   extern void *C_linklist_peek(c_linklist_t *l);
@@ -158,6 +165,8 @@ extern "C" {
 
 #define C_queue_set_destructor(Q, D)            \
   C_linklist_set_destructor((Q), (D))
+#define C_queue_set_slab(Q, A)                  \
+  C_linklist_set_slab((Q), (A))
 
 #define C_queue_enqueue(Q, D) C_linklist_append((Q), (D))
 
@@ -165,6 +174,155 @@ extern "C" {
 
 #define C_queue_length(Q) C_linklist_length(Q)
 
+/* ----------------------------------------------------------------------------
+ * deques
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_deque_t
+  {
+    void **items;
+    uint_t capacity;
+    uint_t head;
+    uint_t size;
+    void (*destructor)(void *);
+  } c_deque_t;
+
+  extern c_deque_t *C_deque_create(uint_t capacity);
+  extern void C_deque_destroy(c_deque_t *d);
+
+  extern c_bool_t C_deque_set_destructor(c_deque_t *d,
+                                         void (*destructor)(void *));
+
+  extern c_bool_t C_deque_push_back(c_deque_t *d, const void *data);
+  extern c_bool_t C_deque_push_front(c_deque_t *d, const void *data);
+  extern void *C_deque_pop_back(c_deque_t *d);
+  extern void *C_deque_pop_front(c_deque_t *d);
+  extern void *C_deque_peek_back(c_deque_t *d);
+  extern void *C_deque_peek_front(c_deque_t *d);
+
+  extern void *C_deque_get(c_deque_t *d, uint_t index);
+  extern c_bool_t C_deque_reserve(c_deque_t *d, uint_t capacity);
+  extern void C_deque_clear(c_deque_t *d);
+
+#define C_deque_length(D) ((D)->size)
+#define C_deque_capacity(D) ((D)->capacity)
+
+/* array-backed stacks and queues, with the same interfaces as the
+   list-backed ones */
+
+  typedef c_deque_t c_astack_t;
+
+#define C_astack_create() C_deque_create(0)
+#define C_astack_destroy(S) C_deque_destroy(S)
+
+#define C_astack_set_destructor(S, D)           \
+  C_deque_set_destructor((S), (D))
+
+#define C_astack_push(S, D) C_deque_push_back((S), (D))
+#define C_astack_pop(S) C_deque_pop_back(S)
+#define C_astack_peek(S) C_deque_peek_back(S)
+
+#define C_astack_depth(S) C_deque_length(S)
+
+  typedef c_deque_t c_aqueue_t;
+
+#define C_aqueue_create() C_deque_create(0)
+#define C_aqueue_destroy(Q) C_deque_destroy(Q)
+
+#define C_aqueue_set_destructor(Q, D)           \
+  C_deque_set_destructor((Q), (D))
+
+#define C_aqueue_enqueue(Q, D) C_deque_push_back((Q), (D))
+
+#define C_aqueue_dequeue(Q) C_deque_pop_front(Q)
+
+#define C_aqueue_length(Q) C_deque_length(Q)
+
+/* ----------------------------------------------------------------------------
+ * heaps
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef uint_t c_heap_handle_t;
+
+  typedef struct c_heap_t
+  {
+    void *entries;
+    void *slots;
+    uint_t size;
+    uint_t capacity;
+    uint_t free_list;
+    void (*destructor)(void *);
+  } c_heap_t;
+
+  extern c_heap_t *C_heap_create(uint_t capacity);
+  extern c_heap_t *C_heap_create_from(const int64_t *keys,
+                                      void * const *data, uint_t n);
+  extern void C_heap_destroy(c_heap_t *h);
+
+  extern c_bool_t C_heap_set_destructor(c_heap_t *h,
+                                        void (*destructor)(void *));
+
+  extern c_bool_t C_heap_push(c_heap_t *h, int64_t key, const void *data,
+                              c_heap_handle_t *handle);
+  extern void *C_heap_pop(c_heap_t *h, int64_t *key);
+  extern void *C_heap_peek(c_heap_t *h, int64_t *key);
+
+  extern c_bool_t C_heap_decrease_key(c_heap_t *h, c_heap_handle_t handle,
+                                      int64_t key);
+  extern c_bool_t C_heap_update_key(c_heap_t *h, c_heap_handle_t handle,
+                                    int64_t key);
+  extern void *C_heap_remove(c_heap_t *h, c_heap_handle_t handle,
+                             int64_t *key);
+  extern void *C_heap_get(c_heap_t *h, c_heap_handle_t handle,
+                          int64_t *key);
+
+  extern void C_heap_clear(c_heap_t *h);
+
+#define C_heap_size(H) ((H)->size)
+#define C_heap_capacity(H) ((H)->capacity)
+
+/* ----------------------------------------------------------------------------
+ * ring queues
+ * ----------------------------------------------------------------------------
+ */
+
+#define C_RINGQUEUE_LINE 64
+
+  typedef struct c_ringqueue_t
+  {
+    void *slots;
+    uint_t mask;
+    int flags;
+    char pad0[C_RINGQUEUE_LINE - sizeof(void *) - sizeof(uint_t)
+              - sizeof(int)];
+    uint64_t head;
+    char pad1[C_RINGQUEUE_LINE - sizeof(uint64_t)];
+    uint64_t tail;
+    char pad2[C_RINGQUEUE_LINE - sizeof(uint64_t)];
+  } c_ringqueue_t;
+
+#define C_RINGQUEUE_SINGLE_PRODUCER 0x01
+#define C_RINGQUEUE_SINGLE_CONSUMER 0x02
+#define C_RINGQUEUE_SPSC                                        \
+  (C_RINGQUEUE_SINGLE_PRODUCER | C_RINGQUEUE_SINGLE_CONSUMER)
+
+  extern c_ringqueue_t *C_ringqueue_create(uint_t capacity, int flags);
+  extern void C_ringqueue_destroy(c_ringqueue_t *q);
+
+  extern c_bool_t C_ringqueue_enqueue(c_ringqueue_t *q, const void *data);
+  extern void *C_ringqueue_dequeue(c_ringqueue_t *q);
+
+  extern uint_t C_ringqueue_enqueue_batch(c_ringqueue_t *q,
+                                          void * const *data, uint_t n);
+  extern uint_t C_ringqueue_dequeue_batch(c_ringqueue_t *q, void **data,
+                                          uint_t n);
+
+  extern size_t C_ringqueue_length(c_ringqueue_t *q);
+
+#define C_ringqueue_capacity(Q) ((Q)->mask + 1)
+
 /* ----------------------------------------------------------------------------
  * dynamic arrays
  * ----------------------------------------------------------------------------
@@ -176,32 +334,56 @@ extern "C" {
     uint_t resize;
     size_t elemsz;
     uint_t size;
-    uint_t isize;
     uint_t bot;
     uint_t del_count;
-    char *free_list;
+    uint64_t *free_map;
+    uint64_t *free_sum;
+    uint_t map_words;
+    uint_t free_hint;
     uint_t iresize;
+    float growth;
+    struct c_memfile_t *file;
   } c_darray_t;
 
 #define C_darray_size(A) ((A)->bot - (A)->del_count)
 #define C_darray_last(A) ((A)->bot)
 
+#define C_darray_capacity(A) ((A)->size)
+
 #define C_DARRAY_MAX_RESIZE 100
+#define C_DARRAY_DEFAULT_GROWTH 1.5
+
+#define C_DARRAY_MAP_SHARED  0x00
+#define C_DARRAY_MAP_PRIVATE 0x01
+#define C_DARRAY_MAP_VERIFY  0x02
 
   extern c_darray_t *C_darray_create(uint_t resize, size_t elemsz);
   extern void C_darray_destroy(c_darray_t *a);
 
+  extern c_bool_t C_darray_set_growth(c_darray_t *a, float factor);
+  extern c_bool_t C_darray_reserve(c_darray_t *a, uint_t size);
+
   extern void *C_darray_store(c_darray_t *a, const void *data, uint_t *index);
   extern void *C_darray_restore(c_darray_t *a, uint_t index);
   extern c_bool_t C_darray_delete(c_darray_t *a, uint_t index);
 
   extern c_darray_t *C_darray_load(const char *path);
   extern c_bool_t C_darray_save(c_darray_t *a, const char *path);
+  extern c_darray_t *C_darray_map(const char *path, int flags);
+  extern c_bool_t C_darray_sync(c_darray_t *a);
   extern c_darray_t *C_darray_defragment(c_darray_t *a);
   extern c_bool_t C_darray_iterate(c_darray_t *a,
                                    c_bool_t (*iter)(void *elem, uint_t index,
                                                     void *hook),
                                    uint_t index, void *hook);
+  extern c_bool_t C_darray_iterate_parallel(c_darray_t *a,
+                                            c_bool_t (*iter)(void *elem,
+                                                             uint_t index,
+                                                             void *hook),
+                                            uint_t nworkers, void **hooks,
+                                            void (*reduce)(void *hook,
+                                                           void *result),
+                                            void *result);
 
 /* ----------------------------------------------------------------------------
  * dynamic strings
@@ -253,37 +435,256 @@ extern "C" {
   {
     char *key;
     void *data;
+    size_t keylen;
+    uint64_t hash;
   } c_tag_t;
 
 #define C_tag_key(T) ((T)->key)
 #define C_tag_data(T) ((T)->data)
 
+  typedef uint64_t (*c_hashfunc_t)(const void * /* key */, size_t /* len */,
+                                   uint64_t /* seed */);
+
+  typedef struct c_hashslot_t
+  {
+    uint64_t hash;
+    char *key;
+    size_t keylen;
+    void *data;
+  } c_hashslot_t;
+
   typedef struct c_hashtable_t
   {
     uint_t buckets;
     c_linklist_t **table;
     size_t size;
     void (*destructor)(void *);
+    int flags;
+    c_hashslot_t *slots;
+    uint_t shift;
+    size_t threshold;
+    float load_factor;
+    c_hashslot_t *old_slots;
+    uint_t old_buckets;
+    uint_t old_shift;
+    uint_t rehash_pos;
+    c_hashfunc_t hashfunc;
+    uint64_t seed;
+    struct c_slab_t *slab;
   } c_hashtable_t;
 
+  typedef struct c_hashtable_iter_t
+  {
+    c_hashtable_t *table;
+    uint_t pos;
+    c_bool_t old;
+    c_link_t *link;
+  } c_hashtable_iter_t;
+
 #define C_hashtable_size(H) ((H)->size)
 
+#define C_hashtable_isrehashing(H) ((H)->old_slots != NULL)
+
+#define C_HASHTABLE_OPEN          0x01
+#define C_HASHTABLE_INCREMENTAL   0x02
+#define C_HASHTABLE_RANDOM_SEED   0x04
+#define C_HASHTABLE_BORROWED_KEYS 0x08
+
+#define C_HASHTABLE_DEFAULT_LOAD_FACTOR 0.75
+
   extern c_hashtable_t *C_hashtable_create(uint_t buckets);
+  extern c_hashtable_t *C_hashtable_create_flags(uint_t buckets, int flags);
   extern void C_hashtable_destroy(c_hashtable_t *h);
 
   extern c_bool_t C_hashtable_set_destructor(c_hashtable_t *h,
                                              void (*destructor)(void *));
 
-  extern c_bool_t C_hashtable_set_hashfunc(uint_t (*func)(const char *s,
-                                                          uint_t modulo));
+  extern c_bool_t C_hashtable_set_hashfunc(c_hashtable_t *h,
+                                           c_hashfunc_t func);
+  extern c_bool_t C_hashtable_set_seed(c_hashtable_t *h, uint64_t seed);
+  extern c_bool_t C_hashtable_set_slab(c_hashtable_t *h,
+                                       struct c_slab_t *slab);
 
   extern c_bool_t C_hashtable_store(c_hashtable_t *h, const char *key,
                                     const void *data);
   extern void *C_hashtable_restore(c_hashtable_t *h, const char *key);
   extern c_bool_t C_hashtable_delete(c_hashtable_t *h, const char *key);
 
+  extern c_bool_t C_hashtable_store_len(c_hashtable_t *h, const void *key,
+                                        size_t len, const void *data);
+  extern void *C_hashtable_restore_len(c_hashtable_t *h, const void *key,
+                                       size_t len);
+  extern c_bool_t C_hashtable_delete_len(c_hashtable_t *h, const void *key,
+                                         size_t len);
+
+  extern void **C_hashtable_find_or_insert(c_hashtable_t *h, const char *key,
+                                           c_bool_t *inserted);
+  extern void **C_hashtable_find_or_insert_len(c_hashtable_t *h,
+                                               const void *key, size_t len,
+                                               c_bool_t *inserted);
+  extern void **C_hashtable_upsert(c_hashtable_t *h, const char *key,
+                                   const void *data);
+  extern void **C_hashtable_upsert_len(c_hashtable_t *h, const void *key,
+                                       size_t len, const void *data);
+
   extern char **C_hashtable_keys(c_hashtable_t *h, size_t *len);
 
+  extern void C_hashtable_iter_init(c_hashtable_t *h,
+                                    c_hashtable_iter_t *iter);
+  extern c_bool_t C_hashtable_iter_next(c_hashtable_iter_t *iter,
+                                        const char **key, size_t *len,
+                                        void **data);
+  extern c_bool_t C_hashtable_iterate(c_hashtable_t *h,
+                                      c_bool_t (*consumer)(const char *key,
+                                                           size_t len,
+                                                           void *data,
+                                                           void *hook),
+                                      void *hook);
+
+  extern c_bool_t C_hashtable_set_load_factor(c_hashtable_t *h, float factor);
+  extern c_bool_t C_hashtable_rehash_step(c_hashtable_t *h, uint_t steps);
+
+/* ----------------------------------------------------------------------------
+ * concurrent hashtables
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_chashtable_t
+  {
+    uint_t nshards;
+    void *shards;
+    c_hashfunc_t hashfunc;
+    uint64_t seed;
+  } c_chashtable_t;
+
+#define C_CHASHTABLE_DEFAULT_SHARDS 32
+
+#define C_chashtable_shards(H) ((H)->nshards)
+
+  extern c_chashtable_t *C_chashtable_create(uint_t shards, uint_t buckets,
+                                             int flags);
+  extern void C_chashtable_destroy(c_chashtable_t *h);
+
+  extern c_bool_t C_chashtable_set_destructor(c_chashtable_t *h,
+                                              void (*destructor)(void *));
+  extern c_bool_t C_chashtable_set_hashfunc(c_chashtable_t *h,
+                                            c_hashfunc_t func);
+  extern c_bool_t C_chashtable_set_seed(c_chashtable_t *h, uint64_t seed);
+
+  extern c_bool_t C_chashtable_store(c_chashtable_t *h, const char *key,
+                                     const void *data);
+  extern void *C_chashtable_restore(c_chashtable_t *h, const char *key);
+  extern c_bool_t C_chashtable_delete(c_chashtable_t *h, const char *key);
+
+  extern c_bool_t C_chashtable_store_len(c_chashtable_t *h, const void *key,
+                                         size_t len, const void *data);
+  extern void *C_chashtable_restore_len(c_chashtable_t *h, const void *key,
+                                        size_t len);
+  extern c_bool_t C_chashtable_delete_len(c_chashtable_t *h, const void *key,
+                                          size_t len);
+
+  extern size_t C_chashtable_size(c_chashtable_t *h);
+  extern c_bool_t C_chashtable_iterate(c_chashtable_t *h,
+                                       c_bool_t (*consumer)(const char *key,
+                                                            size_t len,
+                                                            void *data,
+                                                            void *hook),
+                                       void *hook);
+
+/* ----------------------------------------------------------------------------
+ * perfect hash tables
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_phtable_t
+  {
+    struct c_memfile_t *file;
+    const char *base;
+    size_t length;
+    size_t size;
+    uint_t nbuckets;
+    uint64_t seed;
+    const uint32_t *disp;
+    const uint64_t *index;
+  } c_phtable_t;
+
+#define C_phtable_size(T) ((T)->size)
+
+  extern c_bool_t C_hashtable_freeze(c_hashtable_t *h, const char *file,
+                                     size_t (*valuelen)(const void *data));
+
+  extern c_phtable_t *C_phtable_open(const char *file);
+  extern c_bool_t C_phtable_close(c_phtable_t *t);
+
+  extern const void *C_phtable_restore(c_phtable_t *t, const char *key);
+  extern const void *C_phtable_restore_len(c_phtable_t *t, const void *key,
+                                           size_t len, size_t *vallen);
+
+/* ----------------------------------------------------------------------------
+ * hash array mapped tries
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_hamt_t
+  {
+    void *root;
+    size_t size;
+    uint_t refs;
+    c_hashfunc_t hashfunc;
+    uint64_t seed;
+    void (*destructor)(void *);
+  } c_hamt_t;
+
+  typedef struct c_hamtref_t
+  {
+    c_hamt_t *current;
+    uint_t epoch;
+    uint_t readers[2];
+    void *lock;
+  } c_hamtref_t;
+
+#define C_hamt_size(T) ((T)->size)
+
+  extern c_hamt_t *C_hamt_create(int flags);
+  extern c_hamt_t *C_hamt_retain(c_hamt_t *t);
+  extern void C_hamt_release(c_hamt_t *t);
+
+  extern c_bool_t C_hamt_set_destructor(c_hamt_t *t,
+                                        void (*destructor)(void *));
+  extern c_bool_t C_hamt_set_hashfunc(c_hamt_t *t, c_hashfunc_t func);
+  extern c_bool_t C_hamt_set_seed(c_hamt_t *t, uint64_t seed);
+
+  extern c_hamt_t *C_hamt_store(c_hamt_t *t, const char *key,
+                                const void *data);
+  extern void *C_hamt_restore(c_hamt_t *t, const char *key);
+  extern c_hamt_t *C_hamt_delete(c_hamt_t *t, const char *key);
+
+  extern c_hamt_t *C_hamt_store_len(c_hamt_t *t, const void *key, size_t len,
+                                    const void *data);
+  extern void *C_hamt_restore_len(c_hamt_t *t, const void *key, size_t len);
+  extern c_hamt_t *C_hamt_delete_len(c_hamt_t *t, const void *key,
+                                     size_t len);
+
+  extern c_bool_t C_hamt_iterate(c_hamt_t *t,
+                                 c_bool_t (*consumer)(const char *key,
+                                                      size_t len, void *data,
+                                                      void *hook),
+                                 void *hook);
+
+  extern c_hamtref_t *C_hamtref_create(c_hamt_t *t);
+  extern void C_hamtref_destroy(c_hamtref_t *r);
+
+  extern c_hamt_t *C_hamtref_acquire(c_hamtref_t *r);
+  extern c_bool_t C_hamtref_publish(c_hamtref_t *r, c_hamt_t *t);
+
+  extern c_bool_t C_hamtref_store(c_hamtref_t *r, const char *key,
+                                  const void *data);
+  extern c_bool_t C_hamtref_store_len(c_hamtref_t *r, const void *key,
+                                      size_t len, const void *data);
+  extern c_bool_t C_hamtref_delete(c_hamtref_t *r, const char *key);
+  extern c_bool_t C_hamtref_delete_len(c_hamtref_t *r, const void *key,
+                                       size_t len);
+
 /* ----------------------------------------------------------------------------
  * b-trees
  * ----------------------------------------------------------------------------
@@ -306,7 +707,9 @@ extern "C" {
   typedef struct c_btree_node_t
   {
     uint_t count;
-    c_datum_t *keys;
+    uint_t total;
+    c_id_t *keys;
+    void **values;
     struct c_btree_node_t **children;
   } c_btree_node_t;
 
@@ -315,7 +718,9 @@ extern "C" {
     c_btree_node_t *root;
     uint_t order;
     uint_t nkeys;
+    c_bool_t counted;
     void (*destructor)(void *);
+    struct c_slab_t *slab;
   } c_btree_t;
 
   extern c_btree_t *C_btree_create(uint_t order);
@@ -323,10 +728,16 @@ extern "C" {
 
   extern c_bool_t C_btree_set_destructor(c_btree_t *tree,
                                          void (*destructor)(void *));
+  extern c_bool_t C_btree_set_slab(c_btree_t *tree, struct c_slab_t *slab);
+  extern size_t C_btree_node_size(uint_t order);
 
   extern c_bool_t C_btree_store(c_btree_t *tree, c_id_t key, const void *data);
   extern void *C_btree_restore(c_btree_t *tree, c_id_t key);
 
+  extern void **C_btree_find_or_insert(c_btree_t *tree, c_id_t key,
+                                       c_bool_t *inserted);
+  extern void **C_btree_upsert(c_btree_t *tree, c_id_t key, const void *data);
+
   extern c_bool_t C_btree_delete(c_btree_t *tree, c_id_t key);
 
   extern c_bool_t C_btree_iterate(c_btree_t *btree,
@@ -336,6 +747,264 @@ extern "C" {
 #define C_btree_order(T)                        \
   ((T)->order)
 
+/* A cursor holds the path from the root to its current element; with a
+   minimum of order + 1 children per interior node, 48 levels is enough
+   for any tree that fits in memory. */
+
+#define C_BTREE_CURSOR_DEPTH 48
+
+  typedef struct c_btree_cursor_t
+  {
+    c_btree_t *tree;
+    int depth;
+    c_id_t limit;
+    c_btree_node_t *node[C_BTREE_CURSOR_DEPTH];
+    uint_t pos[C_BTREE_CURSOR_DEPTH];
+  } c_btree_cursor_t;
+
+#define C_btree_cursor_key(C)                                   \
+  ((C)->node[(C)->depth]->keys[(C)->pos[(C)->depth]])
+
+#define C_btree_cursor_value(C)                                 \
+  ((C)->node[(C)->depth]->values[(C)->pos[(C)->depth]])
+
+#define C_btree_cursor_isvalid(C)               \
+  ((C)->depth >= 0)
+
+#define C_BTREE_MIN_FILL 0.5
+
+  extern c_bool_t C_btree_bulk_load(c_btree_t *tree, const c_datum_t *data,
+                                    size_t n, float fill);
+
+  extern void *C_btree_min(c_btree_t *tree, c_id_t *key);
+  extern void *C_btree_max(c_btree_t *tree, c_id_t *key);
+
+  extern c_bool_t C_btree_set_counted(c_btree_t *tree, c_bool_t counted);
+  extern size_t C_btree_rank(c_btree_t *tree, c_id_t key);
+  extern void *C_btree_select(c_btree_t *tree, size_t k, c_id_t *key);
+  extern size_t C_btree_count_range(c_btree_t *tree, c_id_t lo, c_id_t hi);
+
+  extern c_bool_t C_btree_cursor_init(c_btree_t *tree,
+                                      c_btree_cursor_t *cursor);
+  extern c_bool_t C_btree_cursor_set_limit(c_btree_cursor_t *cursor,
+                                           c_id_t limit);
+  extern c_bool_t C_btree_cursor_seek(c_btree_cursor_t *cursor, c_id_t key);
+  extern c_bool_t C_btree_cursor_first(c_btree_cursor_t *cursor);
+  extern c_bool_t C_btree_cursor_last(c_btree_cursor_t *cursor);
+  extern c_bool_t C_btree_cursor_next(c_btree_cursor_t *cursor);
+  extern c_bool_t C_btree_cursor_prev(c_btree_cursor_t *cursor);
+
+/* ----------------------------------------------------------------------------
+ * string-keyed b-trees
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef int (*c_compfunc_t)(const void * /* key1 */, size_t /* len1 */,
+                              const void * /* key2 */, size_t /* len2 */);
+
+  typedef struct c_sbtree_t
+  {
+    void *root;
+    uint_t order;
+    uint_t nkeys;
+    size_t size;
+    c_compfunc_t compare;
+    void (*destructor)(void *);
+  } c_sbtree_t;
+
+  typedef struct c_sbtree_cursor_t
+  {
+    c_sbtree_t *tree;
+    void *node;
+    uint_t pos;
+    const void *limit;
+    size_t limitlen;
+  } c_sbtree_cursor_t;
+
+#define C_sbtree_size(T)                        \
+  ((T)->size)
+
+#define C_sbtree_order(T)                       \
+  ((T)->order)
+
+#define C_sbtree_cursor_isvalid(C)              \
+  ((C)->node != NULL)
+
+  extern c_sbtree_t *C_sbtree_create(uint_t order);
+  extern void C_sbtree_destroy(c_sbtree_t *tree);
+
+  extern c_bool_t C_sbtree_set_destructor(c_sbtree_t *tree,
+                                          void (*destructor)(void *));
+  extern c_bool_t C_sbtree_set_comparator(c_sbtree_t *tree,
+                                          c_compfunc_t compare);
+
+  extern c_bool_t C_sbtree_store(c_sbtree_t *tree, const char *key,
+                                 const void *data);
+  extern c_bool_t C_sbtree_store_len(c_sbtree_t *tree, const void *key,
+                                     size_t len, const void *data);
+  extern void *C_sbtree_restore(c_sbtree_t *tree, const char *key);
+  extern void *C_sbtree_restore_len(c_sbtree_t *tree, const void *key,
+                                    size_t len);
+  extern c_bool_t C_sbtree_delete(c_sbtree_t *tree, const char *key);
+  extern c_bool_t C_sbtree_delete_len(c_sbtree_t *tree, const void *key,
+                                      size_t len);
+
+  extern c_bool_t C_sbtree_iterate(c_sbtree_t *tree,
+                                   c_bool_t (*consumer)(const char *key,
+                                                        size_t len,
+                                                        void *data,
+                                                        void *hook),
+                                   void *hook);
+
+  extern c_bool_t C_sbtree_cursor_init(c_sbtree_t *tree,
+                                       c_sbtree_cursor_t *cursor);
+  extern c_bool_t C_sbtree_cursor_set_limit(c_sbtree_cursor_t *cursor,
+                                            const void *limit, size_t len);
+  extern c_bool_t C_sbtree_cursor_seek(c_sbtree_cursor_t *cursor,
+                                       const char *key);
+  extern c_bool_t C_sbtree_cursor_seek_len(c_sbtree_cursor_t *cursor,
+                                           const void *key, size_t len);
+  extern c_bool_t C_sbtree_cursor_first(c_sbtree_cursor_t *cursor);
+  extern c_bool_t C_sbtree_cursor_last(c_sbtree_cursor_t *cursor);
+  extern c_bool_t C_sbtree_cursor_next(c_sbtree_cursor_t *cursor);
+  extern c_bool_t C_sbtree_cursor_prev(c_sbtree_cursor_t *cursor);
+  extern const char *C_sbtree_cursor_key(c_sbtree_cursor_t *cursor,
+                                         size_t *len);
+  extern void *C_sbtree_cursor_value(c_sbtree_cursor_t *cursor);
+
+/* ----------------------------------------------------------------------------
+ * concurrent b-trees
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_cbtree_t
+  {
+    void *root;
+    uint_t order;
+    uint_t nkeys;
+    size_t size;
+    void (*destructor)(void *);
+  } c_cbtree_t;
+
+#define C_cbtree_order(T)                       \
+  ((T)->order)
+
+  extern c_cbtree_t *C_cbtree_create(uint_t order);
+  extern void C_cbtree_destroy(c_cbtree_t *tree);
+
+  extern c_bool_t C_cbtree_set_destructor(c_cbtree_t *tree,
+                                          void (*destructor)(void *));
+
+  extern c_bool_t C_cbtree_store(c_cbtree_t *tree, c_id_t key,
+                                 const void *data);
+  extern void *C_cbtree_restore(c_cbtree_t *tree, c_id_t key);
+  extern c_bool_t C_cbtree_delete(c_cbtree_t *tree, c_id_t key);
+
+  extern c_bool_t C_cbtree_iterate(c_cbtree_t *tree,
+                                   c_bool_t (*consumer)(c_id_t key,
+                                                        void *data,
+                                                        void *hook),
+                                   void *hook);
+  extern size_t C_cbtree_size(c_cbtree_t *tree);
+
+/* ----------------------------------------------------------------------------
+ * disk b-trees
+ * ----------------------------------------------------------------------------
+ */
+
+#define C_DBTREE_DEFAULT_PAGESIZE 4096
+
+  typedef struct c_dbtree_t
+  {
+    struct c_memfile_t *file;
+    c_bool_t readonly;
+    uint_t pagesize;
+    uint_t valsize;
+    uint_t vstride;
+    uint_t lcap;
+    uint_t icap;
+    void *scratch;
+  } c_dbtree_t;
+
+  typedef struct c_dbtree_cursor_t
+  {
+    c_dbtree_t *tree;
+    uint64_t page;
+    uint_t pos;
+    c_id_t limit;
+  } c_dbtree_cursor_t;
+
+#define C_dbtree_valsize(T) ((T)->valsize)
+
+#define C_dbtree_cursor_isvalid(C)              \
+  ((C)->page != 0)
+
+  extern c_dbtree_t *C_dbtree_create(const char *file, uint_t pagesize,
+                                     uint_t valsize);
+  extern c_dbtree_t *C_dbtree_open(const char *file, c_bool_t readonly);
+  extern c_bool_t C_dbtree_close(c_dbtree_t *tree);
+  extern c_bool_t C_dbtree_sync(c_dbtree_t *tree, c_bool_t async);
+
+  extern c_bool_t C_dbtree_store(c_dbtree_t *tree, c_id_t key,
+                                 const void *value);
+  extern void *C_dbtree_restore(c_dbtree_t *tree, c_id_t key);
+  extern c_bool_t C_dbtree_delete(c_dbtree_t *tree, c_id_t key);
+
+  extern c_bool_t C_dbtree_iterate(c_dbtree_t *tree,
+                                   c_bool_t (*consumer)(c_id_t key,
+                                                        void *value,
+                                                        void *hook),
+                                   void *hook);
+  extern size_t C_dbtree_size(c_dbtree_t *tree);
+
+  extern c_bool_t C_dbtree_cursor_init(c_dbtree_t *tree,
+                                       c_dbtree_cursor_t *cursor);
+  extern c_bool_t C_dbtree_cursor_set_limit(c_dbtree_cursor_t *cursor,
+                                            c_id_t limit);
+  extern c_bool_t C_dbtree_cursor_seek(c_dbtree_cursor_t *cursor, c_id_t key);
+  extern c_bool_t C_dbtree_cursor_first(c_dbtree_cursor_t *cursor);
+  extern c_bool_t C_dbtree_cursor_last(c_dbtree_cursor_t *cursor);
+  extern c_bool_t C_dbtree_cursor_next(c_dbtree_cursor_t *cursor);
+  extern c_bool_t C_dbtree_cursor_prev(c_dbtree_cursor_t *cursor);
+  extern c_id_t C_dbtree_cursor_key(c_dbtree_cursor_t *cursor);
+  extern void *C_dbtree_cursor_value(c_dbtree_cursor_t *cursor);
+
+/* ----------------------------------------------------------------------------
+ * integer-keyed maps
+ * ----------------------------------------------------------------------------
+ */
+
+  typedef struct c_idmap_t
+  {
+    c_datum_t *slots;
+    uint_t mask;
+    size_t size;
+    size_t threshold;
+    void (*destructor)(void *);
+  } c_idmap_t;
+
+#define C_idmap_size(M) ((M)->size)
+
+  extern c_idmap_t *C_idmap_create(uint_t capacity);
+  extern void C_idmap_destroy(c_idmap_t *m);
+
+  extern c_bool_t C_idmap_set_destructor(c_idmap_t *m,
+                                         void (*destructor)(void *));
+
+  extern c_bool_t C_idmap_store(c_idmap_t *m, c_id_t key, const void *data);
+  extern void *C_idmap_restore(c_idmap_t *m, c_id_t key);
+  extern c_bool_t C_idmap_delete(c_idmap_t *m, c_id_t key);
+
+  extern void **C_idmap_find_or_insert(c_idmap_t *m, c_id_t key,
+                                       c_bool_t *inserted);
+  extern void **C_idmap_upsert(c_idmap_t *m, c_id_t key, const void *data);
+
+  extern c_bool_t C_idmap_iterate(c_idmap_t *m,
+                                  c_bool_t (*consumer)(c_id_t key,
+                                                       void *elem,
+                                                       void *hook),
+                                  void *hook);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
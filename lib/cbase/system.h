@@ -203,6 +203,7 @@ extern "C" {
   extern size_t C_mem_defrag(void *p, size_t elemsz, size_t len,
                              c_bool_t (*isempty)(void *elem));
   extern void *C_mem_manage(void *p, size_t n, c_bool_t clearf);
+  extern void *C_mem_manage_aligned(size_t n, size_t align, c_bool_t clearf);
   extern void C_mem_set_errorfunc(c_bool_t (*func)(void));
   extern void *C_mem_free(void *p);
   extern void C_mem_free_vec(char **p);
@@ -222,9 +223,9 @@ extern "C" {
   (T *)C_mem_manage((void *)(P), (N) * sizeof(T), FALSE)
 
 #define C_zero(P, T)                            \
-  memset((void *)P, 0, sizeof(T))
+  memset((void *)(P), 0, sizeof(T))
 #define C_zeroa(P, N, T)                        \
-  memset((void *)P, 0, (N) * sizeof(T))
+  memset((void *)(P), 0, (N) * sizeof(T))
 
 #define C_free(P)                               \
   C_mem_free((void *)(P))
@@ -267,6 +268,28 @@ extern "C" {
 #define C_pallocstr(P, N)                       \
   C_palloc((P), (N), char)
 
+  typedef struct c_slab_t
+  {
+    size_t objsize;
+    uint_t perblock;
+    void *blocks;
+    void *free;
+    char *next;
+    uint_t left;
+    size_t count;
+    size_t nblocks;
+  } c_slab_t;
+
+  extern c_slab_t *C_slab_create(size_t objsize, uint_t perblock);
+  extern void C_slab_destroy(c_slab_t *slab);
+  extern void *C_slab_alloc(c_slab_t *slab);
+  extern void C_slab_free(c_slab_t *slab, void *p);
+  extern void C_slab_reset(c_slab_t *slab);
+
+#define C_slab_objsize(S) ((S)->objsize)
+#define C_slab_count(S) ((S)->count)
+#define C_slab_blocks(S) ((S)->nblocks)
+
 /* ----------------------------------------------------------------------------
  * I/O functions & macros
  * ----------------------------------------------------------------------------
@@ -329,9 +352,14 @@ extern "C" {
     int fd;
     void *base;
     off_t length;
+    int flags;
   } c_memfile_t;
 
+#define C_MEMFILE_READONLY 0x01
+#define C_MEMFILE_PRIVATE  0x02
+
   extern c_memfile_t *C_memfile_open(const char *file, c_bool_t readonly);
+  extern c_memfile_t *C_memfile_open_flags(const char *file, int flags);
   extern c_bool_t C_memfile_close(c_memfile_t *f);
   extern c_bool_t C_memfile_resize(c_memfile_t *f, off_t length);
   extern c_bool_t C_memfile_sync(c_memfile_t *f, c_bool_t async);
@@ -29,6 +29,7 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
@@ -141,6 +142,9 @@ extern "C" {
   extern char **C_string_va_makevec(size_t *len, ...);
   extern char **C_string_valist2vec(const char *first, va_list vp, size_t *slen);
   extern uint_t C_string_hash(const char *s, uint_t modulo);
+  extern uint64_t C_string_hash64(const char *s, uint64_t seed);
+  extern uint64_t C_string_hash64_len(const void *s, size_t len,
+                                      uint64_t seed);
   extern int C_string_compare_len(const char *s1, size_t len1,
                                   const char *s2, size_t len2);
   extern int C_string_compare(const void *s1, const void *s2);
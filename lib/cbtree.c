@@ -0,0 +1,739 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <sched.h>
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_CBTREE_ALIGN 64
+
+/* Each node carries a version word, whose low bit is set while a writer
+   holds the node, and which advances by 2 with every modification.
+   Readers take no locks: they note a node's version, read the node, and
+   check that the version is unchanged, starting over if it is not. A
+   writer locks only the nodes it modifies, by moving the version it
+   read to the locked state, which fails if the node has changed in the
+   meantime. Since readers may read a node while it is being written,
+   all accesses to node contents are atomic in the threaded library. */
+
+#define __C_CBTREE_LOCKED 1
+
+#ifdef THREADED_LIBRARY
+
+#define __C_cbtree_load(P)                      \
+  __atomic_load_n((P), __ATOMIC_RELAXED)
+#define __C_cbtree_store(P, V)                  \
+  __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+#define __C_cbtree_load_acquire(P)              \
+  __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define __C_cbtree_store_release(P, V)          \
+  __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define __C_cbtree_cas(P, E, V)                                         \
+  __atomic_compare_exchange_n((P), (E), (V), FALSE, __ATOMIC_ACQUIRE,   \
+                              __ATOMIC_RELAXED)
+#define __C_cbtree_add(P, N)                    \
+  __atomic_add_fetch((P), (N), __ATOMIC_RELEASE)
+#define __C_cbtree_fence_acquire()              \
+  __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define __C_cbtree_fence_release()              \
+  __atomic_thread_fence(__ATOMIC_RELEASE)
+#define __C_cbtree_pause()                      \
+  sched_yield()
+
+#else
+
+#define __C_cbtree_load(P) (*(P))
+#define __C_cbtree_store(P, V) (*(P) = (V))
+#define __C_cbtree_load_acquire(P) (*(P))
+#define __C_cbtree_store_release(P, V) (*(P) = (V))
+#define __C_cbtree_cas(P, E, V)                                         \
+  ((*(P) == *(E)) ? ((*(P) = (V)), TRUE) : ((*(E) = *(P)), FALSE))
+#define __C_cbtree_add(P, N) (*(P) += (N))
+#define __C_cbtree_fence_acquire()
+#define __C_cbtree_fence_release()
+#define __C_cbtree_pause()
+
+#endif /* THREADED_LIBRARY */
+
+/* A node is a single allocation: this header, then the keys, then the
+   slots, which hold values in a leaf and children in an interior node.
+   The kind of a node never changes once it is created. */
+
+typedef struct __c_cbtree_node_t
+{
+  uint64_t version;
+  uint_t count;
+  c_bool_t leaf;
+  c_id_t *keys;
+  void **slots;
+} __c_cbtree_node_t;
+
+#define __C_CBTREE_HEADER_SIZE                                          \
+  ((sizeof(__c_cbtree_node_t) + 31) & ~(size_t)31)
+
+/* File scope functions */
+
+static __c_cbtree_node_t *__C_cbtree_create_node(c_cbtree_t *tree,
+                                                 c_bool_t leaf)
+{
+  __c_cbtree_node_t *node;
+  char *p;
+
+  p = (char *)C_mem_manage_aligned(__C_CBTREE_HEADER_SIZE
+                                   + (tree->nkeys * sizeof(c_id_t))
+                                   + ((tree->nkeys + 1) * sizeof(void *)),
+                                   __C_CBTREE_ALIGN, TRUE);
+
+  if(!p)
+    return(NULL);
+
+  node = (__c_cbtree_node_t *)p;
+  node->leaf = leaf;
+  node->keys = (c_id_t *)(p + __C_CBTREE_HEADER_SIZE);
+  node->slots = (void **)(node->keys + tree->nkeys);
+
+  return(node);
+}
+
+/*
+ */
+
+static void __C_cbtree_destroy_node(c_cbtree_t *tree, __c_cbtree_node_t *node)
+{
+  uint_t i;
+
+  if(node->leaf)
+  {
+    if(tree->destructor)
+    {
+      for(i = 0; i < node->count; ++i)
+      {
+        if(node->slots[i])
+          tree->destructor(node->slots[i]);
+      }
+    }
+  }
+  else
+  {
+    for(i = 0; i <= node->count; ++i)
+      __C_cbtree_destroy_node(tree, (__c_cbtree_node_t *)node->slots[i]);
+  }
+
+  C_free(node);
+}
+
+/*
+ */
+
+static c_bool_t __C_cbtree_read_lock(__c_cbtree_node_t *node, uint64_t *version)
+{
+  *version = __C_cbtree_load_acquire(&(node->version));
+
+  if(*version & __C_CBTREE_LOCKED)
+  {
+    __C_cbtree_pause();
+    return(FALSE);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static c_bool_t __C_cbtree_validate(__c_cbtree_node_t *node, uint64_t version)
+{
+  /* everything read from the node must be read before the version is
+     checked again */
+
+  __C_cbtree_fence_acquire();
+
+  return(__C_cbtree_load_acquire(&(node->version)) == version);
+}
+
+/*
+ */
+
+static c_bool_t __C_cbtree_upgrade(__c_cbtree_node_t *node, uint64_t version)
+{
+  if(! __C_cbtree_cas(&(node->version), &version,
+                      version + __C_CBTREE_LOCKED))
+    return(FALSE);
+
+  /* order the lock before any of the writes that follow it */
+
+  __C_cbtree_fence_release();
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void __C_cbtree_unlock(__c_cbtree_node_t *node)
+{
+  __C_cbtree_add(&(node->version), __C_CBTREE_LOCKED);
+}
+
+/*
+ */
+
+static uint_t __C_cbtree_count(c_cbtree_t *tree, __c_cbtree_node_t *node)
+{
+  uint_t n = __C_cbtree_load(&(node->count));
+
+  /* a reader may see a count that is being changed; keep it in bounds,
+     and let validation catch the inconsistency */
+
+  return((n > tree->nkeys) ? tree->nkeys : n);
+}
+
+/*
+ */
+
+static uint_t __C_cbtree_search(__c_cbtree_node_t *node, uint_t n, c_id_t key)
+{
+  uint_t lo = 0, hi = n, mid;
+
+  /* Returns the index of the first key not less than key. */
+
+  while(lo < hi)
+  {
+    mid = (lo + hi) / 2;
+
+    if(__C_cbtree_load(&(node->keys[mid])) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return(lo);
+}
+
+/*
+ */
+
+static uint_t __C_cbtree_child(__c_cbtree_node_t *node, uint_t n, c_id_t key)
+{
+  uint_t i = __C_cbtree_search(node, n, key);
+
+  /* a separator is the smallest key in the subtree to its right */
+
+  if((i < n) && (__C_cbtree_load(&(node->keys[i])) == key))
+    ++i;
+
+  return(i);
+}
+
+/*
+ */
+
+static void __C_cbtree_insert_at(__c_cbtree_node_t *node, uint_t i,
+                                 c_id_t key, void *slot)
+{
+  uint_t j, n = node->count;
+
+  /* Inserts a key and the slot that follows it: in a leaf, the key's
+     value; in an interior node, the child to the key's right. The node
+     is locked, so its contents may be read directly, but must be
+     written atomically. */
+
+  if(node->leaf)
+  {
+    for(j = n; j > i; --j)
+    {
+      __C_cbtree_store(&(node->keys[j]), node->keys[j - 1]);
+      __C_cbtree_store(&(node->slots[j]), node->slots[j - 1]);
+    }
+
+    __C_cbtree_store(&(node->slots[i]), slot);
+  }
+  else
+  {
+    for(j = n; j > i; --j)
+    {
+      __C_cbtree_store(&(node->keys[j]), node->keys[j - 1]);
+      __C_cbtree_store(&(node->slots[j + 1]), node->slots[j]);
+    }
+
+    __C_cbtree_store(&(node->slots[i + 1]), slot);
+  }
+
+  __C_cbtree_store(&(node->keys[i]), key);
+  __C_cbtree_store(&(node->count), n + 1);
+}
+
+/*
+ */
+
+static __c_cbtree_node_t *__C_cbtree_split(c_cbtree_t *tree,
+                                           __c_cbtree_node_t *node,
+                                           c_id_t *sep)
+{
+  __c_cbtree_node_t *right;
+  uint_t m, n = node->count;
+
+  /* Moves the upper half of the locked node into a new right sibling,
+     and returns the sibling and the separator for the parent. The
+     sibling is not visible to other threads until it is linked into the
+     parent. */
+
+  if(!(right = __C_cbtree_create_node(tree, node->leaf)))
+    return(NULL);
+
+  m = n / 2;
+
+  if(node->leaf)
+  {
+    right->count = n - m;
+    memcpy(right->keys, node->keys + m, right->count * sizeof(c_id_t));
+    memcpy(right->slots, node->slots + m, right->count * sizeof(void *));
+    *sep = right->keys[0];
+  }
+  else
+  {
+    right->count = n - m - 1;
+    memcpy(right->keys, node->keys + m + 1, right->count * sizeof(c_id_t));
+    memcpy(right->slots, node->slots + m + 1,
+           (right->count + 1) * sizeof(void *));
+    *sep = node->keys[m];
+  }
+
+  __C_cbtree_store(&(node->count), m);
+
+  return(right);
+}
+
+/*
+ */
+
+static c_bool_t __C_cbtree_split_node(c_cbtree_t *tree,
+                                      __c_cbtree_node_t *node,
+                                      __c_cbtree_node_t *parent)
+{
+  __c_cbtree_node_t *right, *root;
+  c_id_t sep;
+
+  /* Splits the locked, full node, whose locked parent has room for
+     another child, or which is the root. */
+
+  if(!(right = __C_cbtree_split(tree, node, &sep)))
+    return(FALSE);
+
+  if(parent)
+  {
+    __C_cbtree_insert_at(parent, __C_cbtree_search(parent, parent->count, sep),
+                         sep, right);
+    return(TRUE);
+  }
+
+  if(!(root = __C_cbtree_create_node(tree, FALSE)))
+    return(FALSE);
+
+  root->count = 1;
+  root->keys[0] = sep;
+  root->slots[0] = node;
+  root->slots[1] = right;
+
+  __C_cbtree_store_release(&(tree->root), root);
+
+  return(TRUE);
+}
+
+/* Functions */
+
+c_cbtree_t *C_cbtree_create(uint_t order)
+{
+  c_cbtree_t *tree;
+
+  if(order < 2)
+    return(NULL);
+
+  tree = C_new(c_cbtree_t);
+  tree->order = order;
+  tree->nkeys = order * 2;
+
+  if(!(tree->root = __C_cbtree_create_node(tree, TRUE)))
+    return(C_free(tree));
+
+  return(tree);
+}
+
+/*
+ */
+
+void C_cbtree_destroy(c_cbtree_t *tree)
+{
+  if(!tree)
+    return;
+
+  __C_cbtree_destroy_node(tree, (__c_cbtree_node_t *)tree->root);
+
+  C_free(tree);
+}
+
+/*
+ */
+
+c_bool_t C_cbtree_set_destructor(c_cbtree_t *tree, void (*destructor)(void *))
+{
+  if(!tree)
+    return(FALSE);
+
+  tree->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_cbtree_store(c_cbtree_t *tree, c_id_t key, const void *data)
+{
+  __c_cbtree_node_t *node, *parent, *child;
+  uint64_t version, pversion = 0;
+  uint_t i, n;
+  c_bool_t ok;
+
+  if(!tree || !key)
+    return(FALSE);
+
+RESTART:
+
+  node = (__c_cbtree_node_t *)__C_cbtree_load_acquire(&(tree->root));
+  parent = NULL;
+
+  if(! __C_cbtree_read_lock(node, &version))
+    goto RESTART;
+
+  if(node != __C_cbtree_load_acquire(&(tree->root)))
+    goto RESTART;
+
+  for(;;)
+  {
+    n = __C_cbtree_count(tree, node);
+
+    /* Split full nodes on the way down, so that a split never has to
+       propagate upward: the parent, having been passed through, always
+       has room for another child. After a split, start over. */
+
+    if(n == tree->nkeys)
+    {
+      if(parent && ! __C_cbtree_upgrade(parent, pversion))
+        goto RESTART;
+
+      if(! __C_cbtree_upgrade(node, version))
+      {
+        if(parent)
+          __C_cbtree_unlock(parent);
+
+        goto RESTART;
+      }
+
+      if(!parent && (node != __C_cbtree_load_acquire(&(tree->root))))
+      {
+        /* another thread has split the root */
+        __C_cbtree_unlock(node);
+        goto RESTART;
+      }
+
+      ok = __C_cbtree_split_node(tree, node, parent);
+
+      __C_cbtree_unlock(node);
+
+      if(parent)
+        __C_cbtree_unlock(parent);
+
+      if(!ok)
+        return(FALSE);
+
+      goto RESTART;
+    }
+
+    if(node->leaf)
+      break;
+
+    if(parent && ! __C_cbtree_validate(parent, pversion))
+      goto RESTART;
+
+    parent = node;
+    pversion = version;
+
+    child = (__c_cbtree_node_t *)__C_cbtree_load(
+      &(node->slots[__C_cbtree_child(node, n, key)]));
+
+    if(! __C_cbtree_validate(node, version))
+      goto RESTART;
+
+    node = child;
+
+    if(! __C_cbtree_read_lock(node, &version))
+      goto RESTART;
+  }
+
+  /* lock the leaf, and make sure it is still the right one */
+
+  if(! __C_cbtree_upgrade(node, version))
+    goto RESTART;
+
+  if(parent && ! __C_cbtree_validate(parent, pversion))
+  {
+    __C_cbtree_unlock(node);
+    goto RESTART;
+  }
+
+  i = __C_cbtree_search(node, node->count, key);
+
+  if((i < node->count) && (node->keys[i] == key))
+  {
+    __C_cbtree_unlock(node);
+    return(FALSE);
+  }
+
+  __C_cbtree_insert_at(node, i, key, (void *)data);
+  __C_cbtree_unlock(node);
+
+  __C_cbtree_add(&(tree->size), 1);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_cbtree_restore(c_cbtree_t *tree, c_id_t key)
+{
+  __c_cbtree_node_t *node, *parent, *child;
+  uint64_t version, pversion = 0;
+  uint_t i, n;
+  void *data;
+
+  if(!tree || !key)
+    return(NULL);
+
+RESTART:
+
+  node = (__c_cbtree_node_t *)__C_cbtree_load_acquire(&(tree->root));
+  parent = NULL;
+
+  if(! __C_cbtree_read_lock(node, &version))
+    goto RESTART;
+
+  if(node != __C_cbtree_load_acquire(&(tree->root)))
+    goto RESTART;
+
+  while(! node->leaf)
+  {
+    if(parent && ! __C_cbtree_validate(parent, pversion))
+      goto RESTART;
+
+    parent = node;
+    pversion = version;
+
+    n = __C_cbtree_count(tree, node);
+    child = (__c_cbtree_node_t *)__C_cbtree_load(
+      &(node->slots[__C_cbtree_child(node, n, key)]));
+
+    /* the child pointer may only be followed once it is known to be
+       consistent */
+
+    if(! __C_cbtree_validate(node, version))
+      goto RESTART;
+
+    node = child;
+
+    if(! __C_cbtree_read_lock(node, &version))
+      goto RESTART;
+  }
+
+  n = __C_cbtree_count(tree, node);
+  i = __C_cbtree_search(node, n, key);
+
+  data = NULL;
+
+  if((i < n) && (__C_cbtree_load(&(node->keys[i])) == key))
+    data = __C_cbtree_load(&(node->slots[i]));
+
+  if(parent && ! __C_cbtree_validate(parent, pversion))
+    goto RESTART;
+
+  if(! __C_cbtree_validate(node, version))
+    goto RESTART;
+
+  return(data);
+}
+
+/*
+ */
+
+c_bool_t C_cbtree_delete(c_cbtree_t *tree, c_id_t key)
+{
+  __c_cbtree_node_t *node, *parent, *child;
+  uint64_t version, pversion = 0;
+  uint_t i, j, n;
+  void *data;
+
+  if(!tree || !key)
+    return(FALSE);
+
+RESTART:
+
+  node = (__c_cbtree_node_t *)__C_cbtree_load_acquire(&(tree->root));
+  parent = NULL;
+
+  if(! __C_cbtree_read_lock(node, &version))
+    goto RESTART;
+
+  if(node != __C_cbtree_load_acquire(&(tree->root)))
+    goto RESTART;
+
+  while(! node->leaf)
+  {
+    if(parent && ! __C_cbtree_validate(parent, pversion))
+      goto RESTART;
+
+    parent = node;
+    pversion = version;
+
+    n = __C_cbtree_count(tree, node);
+    child = (__c_cbtree_node_t *)__C_cbtree_load(
+      &(node->slots[__C_cbtree_child(node, n, key)]));
+
+    if(! __C_cbtree_validate(node, version))
+      goto RESTART;
+
+    node = child;
+
+    if(! __C_cbtree_read_lock(node, &version))
+      goto RESTART;
+  }
+
+  if(! __C_cbtree_upgrade(node, version))
+    goto RESTART;
+
+  if(parent && ! __C_cbtree_validate(parent, pversion))
+  {
+    __C_cbtree_unlock(node);
+    goto RESTART;
+  }
+
+  n = node->count;
+  i = __C_cbtree_search(node, n, key);
+
+  if((i == n) || (node->keys[i] != key))
+  {
+    __C_cbtree_unlock(node);
+    return(FALSE);
+  }
+
+  /* Nodes are not merged when they underflow, and so are never freed
+     while the tree is in use; readers may therefore hold stale pointers
+     to nodes without any further reclamation scheme. */
+
+  data = node->slots[i];
+
+  for(j = i + 1; j < n; ++j)
+  {
+    __C_cbtree_store(&(node->keys[j - 1]), node->keys[j]);
+    __C_cbtree_store(&(node->slots[j - 1]), node->slots[j]);
+  }
+
+  __C_cbtree_store(&(node->count), n - 1);
+  __C_cbtree_unlock(node);
+
+  __C_cbtree_add(&(tree->size), -1);
+
+  if(tree->destructor && data)
+    tree->destructor(data);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static c_bool_t __C_cbtree_iterate(__c_cbtree_node_t *node,
+                                   c_bool_t (*consumer)(c_id_t key,
+                                                        void *data,
+                                                        void *hook),
+                                   void *hook)
+{
+  uint_t i;
+
+  for(i = 0; i < node->count; ++i)
+  {
+    if(node->leaf)
+    {
+      if(! consumer(node->keys[i], node->slots[i], hook))
+        return(FALSE);
+    }
+    else if(! __C_cbtree_iterate((__c_cbtree_node_t *)node->slots[i],
+                                 consumer, hook))
+      return(FALSE);
+  }
+
+  if(! node->leaf)
+    return(__C_cbtree_iterate((__c_cbtree_node_t *)node->slots[node->count],
+                              consumer, hook));
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_cbtree_iterate(c_cbtree_t *tree,
+                          c_bool_t (*consumer)(c_id_t key, void *data,
+                                               void *hook),
+                          void *hook)
+{
+  if(!tree || !consumer)
+    return(FALSE);
+
+  return(__C_cbtree_iterate((__c_cbtree_node_t *)tree->root, consumer, hook));
+}
+
+/*
+ */
+
+size_t C_cbtree_size(c_cbtree_t *tree)
+{
+  if(!tree)
+    return(0);
+
+  return(__C_cbtree_load(&(tree->size)));
+}
+
+/* end of source file */
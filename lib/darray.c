@@ -26,42 +26,425 @@
 
 /* System headers */
 
+#include <limits.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef THREADED_LIBRARY
+#include <pthread.h>
+#endif /* THREADED_LIBRARY */
 
 /* Local headers */
 
 #include "cbase/defs.h"
 #include "cbase/data.h"
 #include "cbase/system.h"
+#include "cbase/util.h"
 
 /* Macros */
 
-#define C_DARRAY_NBBY 8
-#define C_DARRAY_USED_MASK(B) ~(1 << (B))
-#define C_DARRAY_FREE_MASK(B) (1 << (B))
+/* Deleted slots are tracked in a two-level bitmap: each bit of the free
+   map is set if the corresponding slot has been deleted, and each bit of
+   the summary is set if the corresponding word of the free map has any
+   bits set. A free slot is found by locating the first nonzero summary
+   word, at or after a hint below which the summary is known to be clear,
+   and then the first set bit in each of two words. */
+
+#define __C_DARRAY_WORD_BITS 64
+
+#define __C_DARRAY_RESIZE_UNIT 8
+
+#define __C_darray_ctz(X) ((uint_t)__builtin_ctzll(X))
+
+#define __C_darray_words(N)                                     \
+  (((N) + __C_DARRAY_WORD_BITS - 1) / __C_DARRAY_WORD_BITS)
+
+#define __C_darray_bit(I)                               \
+  ((uint64_t)1 << ((I) % __C_DARRAY_WORD_BITS))
+
+#define __C_DARRAY_MAGIC "cbaseDA"
+#define __C_DARRAY_VERSION 1
+
+/* A saved array consists of a header, followed by the elements up to the
+   high-water mark, followed, at the next multiple of 8 bytes, by the
+   free map words that cover them. The elements begin at a fixed offset,
+   so that a mapped array can grow in place by extending the file; the
+   free map is rewritten after the last element whenever a mapped array
+   is synced. Everything is stored in native byte order. The checksum
+   covers the elements and the free map. */
+
+typedef struct __c_darray_header_t
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t resize;
+  uint64_t elemsz;
+  uint64_t count;
+  uint64_t del_count;
+  float growth;
+  uint32_t reserved;
+  uint64_t checksum;
+  uint64_t reserved2;
+} __c_darray_header_t;
+
+#define __C_DARRAY_DATA_OFFSET sizeof(__c_darray_header_t)
+
+#define __C_darray_map_offset(A)                                        \
+  ((__C_DARRAY_DATA_OFFSET + ((size_t)(A)->bot * (A)->elemsz) + 7)       \
+   & ~(size_t)7)
+
+#define __C_darray_map_bytes(A)                                 \
+  ((size_t)__C_darray_words((A)->bot) * sizeof(uint64_t))
+
+#ifdef THREADED_LIBRARY
+
+#define __C_darray_load(P)                      \
+  __atomic_load_n((P), __ATOMIC_RELAXED)
+#define __C_darray_store(P, V)                  \
+  __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+
+#else
+
+#define __C_darray_load(P) (*(P))
+#define __C_darray_store(P, V) (*(P) = (V))
+
+#endif /* THREADED_LIBRARY */
+
+/* the state of one worker in a parallel iteration */
+
+typedef struct __c_darray_worker_t
+{
+  c_darray_t *a;
+  c_bool_t (*iter)(void *elem, uint_t index, void *hook);
+  uint_t from;
+  uint_t to;
+  void *hook;
+  int *stop;
+  c_bool_t result;
+#ifdef THREADED_LIBRARY
+  c_bool_t started;
+  pthread_t thread;
+#endif /* THREADED_LIBRARY */
+} __c_darray_worker_t;
+
+/* File scope functions */
+
+static void __C_darray_map_alloc(c_darray_t *a)
+{
+  uint_t words, swords, oswords;
+
+  /* grow the free map and the summary to cover the array's capacity */
+
+  words = __C_darray_words(a->size);
+  if(words <= a->map_words)
+    return;
+
+  oswords = __C_darray_words(a->map_words);
+  swords = __C_darray_words(words);
+
+  a->free_map = C_realloc(a->free_map, words, uint64_t);
+  C_zeroa((a->free_map + a->map_words), words - a->map_words, uint64_t);
+
+  if(swords > oswords)
+  {
+    a->free_sum = C_realloc(a->free_sum, swords, uint64_t);
+    C_zeroa((a->free_sum + oswords), swords - oswords, uint64_t);
+  }
+
+  a->map_words = words;
+}
+
+/*
+ */
+
+static uint_t __C_darray_file_capacity(c_darray_t *a)
+{
+  off_t n = (C_memfile_length(a->file) - (off_t)__C_DARRAY_DATA_OFFSET)
+    / (off_t)a->elemsz;
+
+  return((n > (off_t)UINT_MAX) ? UINT_MAX : (uint_t)n);
+}
+
+/*
+ */
+
+static c_bool_t __C_darray_resize(c_darray_t *a, uint_t size)
+{
+  void *mem;
+
+  if(! a->file)
+    a->mem = (void *)C_realloc(a->mem, (size_t)size * a->elemsz, char);
+  else if(a->file->flags & C_MEMFILE_PRIVATE)
+  {
+    /* a private mapping cannot be extended, so the elements are moved to
+       the heap */
+
+    mem = (void *)C_malloc((size_t)size * a->elemsz, char);
+    memcpy(mem, a->mem, (size_t)a->bot * a->elemsz);
+    C_memfile_close(a->file);
+    a->file = NULL;
+    a->mem = mem;
+  }
+  else
+  {
+    if(! C_memfile_resize(a->file, (off_t)(__C_DARRAY_DATA_OFFSET
+                                           + ((size_t)size * a->elemsz))))
+      return(FALSE);
+
+    a->mem = C_memfile_pointer(a->file, __C_DARRAY_DATA_OFFSET);
+    size = __C_darray_file_capacity(a);
+  }
+
+  a->size = size;
+  __C_darray_map_alloc(a);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static c_bool_t __C_darray_grow(c_darray_t *a)
+{
+  double size;
+
+  /* Grow geometrically, so that filling an array copies each element a
+     constant number of times on average, but never by less than the
+     fixed step; with no growth factor, grow by the fixed step alone. */
+
+  size = (double)a->size + a->resize;
+  if(a->growth > 1.0)
+    size = C_max(size, (double)a->size * a->growth);
+
+  return(__C_darray_resize(a, ((size > (double)UINT_MAX)
+                               ? UINT_MAX : (uint_t)size)));
+}
+
+/*
+ */
+
+static uint_t __C_darray_find_free(c_darray_t *a)
+{
+  uint_t s, w;
+
+  for(s = a->free_hint; !a->free_sum[s]; ++s);
+  a->free_hint = s;
+
+  w = (s * __C_DARRAY_WORD_BITS) + __C_darray_ctz(a->free_sum[s]);
+
+  return((w * __C_DARRAY_WORD_BITS) + __C_darray_ctz(a->free_map[w]));
+}
+
+/*
+ */
+
+static void __C_darray_mark_used(c_darray_t *a, uint_t index)
+{
+  uint_t w = index / __C_DARRAY_WORD_BITS;
+
+  a->free_map[w] &= ~__C_darray_bit(index);
+  if(! a->free_map[w])
+    a->free_sum[w / __C_DARRAY_WORD_BITS] &= ~__C_darray_bit(w);
+}
+
+/*
+ */
+
+static void __C_darray_mark_free(c_darray_t *a, uint_t index)
+{
+  uint_t w = index / __C_DARRAY_WORD_BITS;
+  uint_t s = w / __C_DARRAY_WORD_BITS;
+
+  a->free_map[w] |= __C_darray_bit(index);
+  a->free_sum[s] |= __C_darray_bit(w);
+
+  if(s < a->free_hint)
+    a->free_hint = s;
+}
+
+/*
+ */
+
+static void __C_darray_rebuild_summary(c_darray_t *a)
+{
+  uint_t w;
+
+  C_zeroa(a->free_sum, __C_darray_words(a->map_words), uint64_t);
+  a->free_hint = 0;
+
+  for(w = 0; w < a->map_words; ++w)
+  {
+    if(a->free_map[w])
+      a->free_sum[w / __C_DARRAY_WORD_BITS] |= __C_darray_bit(w);
+  }
+}
+
+/*
+ */
+
+static uint64_t __C_darray_checksum(c_darray_t *a)
+{
+  uint64_t h;
+
+  h = C_string_hash64_len(a->mem, (size_t)a->bot * a->elemsz,
+                          (uint64_t)a->bot);
+
+  return(C_string_hash64_len(a->free_map, __C_darray_map_bytes(a),
+                             h ^ (uint64_t)a->del_count));
+}
+
+/*
+ */
+
+static void __C_darray_put_header(c_darray_t *a, __c_darray_header_t *hdr)
+{
+  C_zero(hdr, __c_darray_header_t);
+  memcpy(hdr->magic, __C_DARRAY_MAGIC, sizeof(hdr->magic));
+  hdr->version = __C_DARRAY_VERSION;
+  hdr->resize = a->iresize;
+  hdr->elemsz = a->elemsz;
+  hdr->count = a->bot;
+  hdr->del_count = a->del_count;
+  hdr->growth = a->growth;
+  hdr->checksum = __C_darray_checksum(a);
+}
+
+/*
+ */
+
+static c_darray_t *__C_darray_get_header(const __c_darray_header_t *hdr,
+                                         off_t length)
+{
+  c_darray_t *a;
+
+  if((length < (off_t)__C_DARRAY_DATA_OFFSET)
+     || memcmp(hdr->magic, __C_DARRAY_MAGIC, sizeof(hdr->magic))
+     || (hdr->version != __C_DARRAY_VERSION)
+     || (hdr->resize < 1) || (hdr->resize > C_DARRAY_MAX_RESIZE)
+     || (hdr->elemsz == 0) || (hdr->elemsz > (uint64_t)length)
+     || (hdr->count > UINT_MAX)
+     || (hdr->del_count > hdr->count))
+    return(NULL);
+
+  a = C_new(c_darray_t);
+  a->iresize = hdr->resize;
+  a->resize = hdr->resize * __C_DARRAY_RESIZE_UNIT;
+  a->elemsz = hdr->elemsz;
+  a->bot = (uint_t)hdr->count;
+  a->del_count = (uint_t)hdr->del_count;
+  a->growth = (((hdr->growth == 0.0) || (hdr->growth > 1.0))
+               ? hdr->growth : C_DARRAY_DEFAULT_GROWTH);
+
+  /* the file must be long enough to hold everything the header claims */
+
+  if((off_t)(__C_darray_map_offset(a) + __C_darray_map_bytes(a)) > length)
+  {
+    C_free(a);
+    return(NULL);
+  }
+
+  return(a);
+}
+
+/*
+ */
+
+static void __C_darray_free(c_darray_t *a)
+{
+  C_free(a->free_map);
+  C_free(a->free_sum);
+  C_free(a);
+}
+
+/*
+ */
+
+static c_bool_t __C_darray_iterate_range(c_darray_t *a,
+                                         c_bool_t (*iter)(void *elem,
+                                                          uint_t index,
+                                                          void *hook),
+                                         uint_t from, uint_t to, void *hook,
+                                         int *stop)
+{
+  uint_t w, last, i;
+  uint64_t used;
+
+  if(from >= to)
+    return(TRUE);
+
+  /* Visit the range a word of the free map at a time: words with no
+     deleted slots (which the summary identifies without reading the
+     map) are visited in a straight run, words in which every slot has
+     been deleted are skipped outright, and only the remaining words are
+     walked bit by bit. */
+
+  last = (to - 1) / __C_DARRAY_WORD_BITS;
+
+  for(w = from / __C_DARRAY_WORD_BITS; w <= last; ++w)
+  {
+    if(stop && __C_darray_load(stop))
+      return(TRUE);
+
+    if(a->free_sum[w / __C_DARRAY_WORD_BITS] & __C_darray_bit(w))
+      used = ~a->free_map[w];
+    else
+      used = ~(uint64_t)0;
+
+    /* clip the word to the range [from, to) */
+
+    if(w == from / __C_DARRAY_WORD_BITS)
+      used &= ~(uint64_t)0 << (from % __C_DARRAY_WORD_BITS);
+    if((w == last) && (to % __C_DARRAY_WORD_BITS))
+      used &= ~(~(uint64_t)0 << (to % __C_DARRAY_WORD_BITS));
+
+    for(; used; used &= (used - 1))
+    {
+      i = (w * __C_DARRAY_WORD_BITS) + __C_darray_ctz(used);
+      if(!iter((void *)(a->mem + (i * a->elemsz)), i, hook))
+        return(FALSE);
+    }
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void *__C_darray_worker(void *arg)
+{
+  __c_darray_worker_t *w = (__c_darray_worker_t *)arg;
+
+  w->result = __C_darray_iterate_range(w->a, w->iter, w->from, w->to,
+                                       w->hook, w->stop);
+
+  /* a worker that is told to stop ends its range early; the others are
+     told to stop at their next word */
+
+  if(! w->result)
+    __C_darray_store(w->stop, 1);
+
+  return(NULL);
+}
 
 /* Functions */
 
 c_darray_t *C_darray_create(uint_t resize, size_t elemsz)
 {
   c_darray_t *a;
-  char *b;
-  uint_t i;
 
   if(resize < 1 || resize > C_DARRAY_MAX_RESIZE || !elemsz)
     return(NULL);
 
   a = C_new(c_darray_t);
-  a->resize = resize * C_DARRAY_NBBY;
+  a->resize = resize * __C_DARRAY_RESIZE_UNIT;
   a->iresize = resize;
   a->elemsz = elemsz;
+  a->growth = C_DARRAY_DEFAULT_GROWTH;
   a->mem = (void *)C_malloc(a->resize * a->elemsz, char);
   a->size = a->resize;
-  a->isize = a->iresize;
   a->bot = a->del_count = 0;
-  a->free_list = C_malloc(a->iresize, char);
-  for(i = a->iresize, b = a->free_list; i--; b++)
-    *b = ~0;
+  __C_darray_map_alloc(a);
 
   return(a);
 }
@@ -75,9 +458,44 @@ void C_darray_destroy(c_darray_t *a)
   if(!a)
     return;
 
-  C_free(a->free_list);
-  C_free(a->mem);
-  C_free(a);
+  if(a->file)
+  {
+    if(!(a->file->flags & C_MEMFILE_PRIVATE))
+      C_darray_sync(a);
+
+    C_memfile_close(a->file);
+  }
+  else
+    C_free(a->mem);
+
+  __C_darray_free(a);
+}
+
+/*
+ */
+
+c_bool_t C_darray_set_growth(c_darray_t *a, float factor)
+{
+  if(!a || ((factor != 0.0) && (factor <= 1.0)))
+    return(FALSE);
+
+  a->growth = factor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_darray_reserve(c_darray_t *a, uint_t size)
+{
+  if(!a)
+    return(FALSE);
+
+  if(size > a->size)
+    return(__C_darray_resize(a, size));
+
+  return(TRUE);
 }
 
 /*
@@ -85,44 +503,24 @@ void C_darray_destroy(c_darray_t *a)
 
 void *C_darray_store(c_darray_t *a, const void *data, uint_t *index)
 {
-  uint_t e, bit, byte, o;
-  char b, *bp;
-  div_t dv;
+  uint_t e;
 
   if(!a)
     return(NULL);
 
   if(!a->del_count)
   {
-    if(a->bot == a->size)
-    {
-      if((a->size / C_DARRAY_NBBY) == a->isize)
-      {
-        o = a->isize;
-        a->free_list = C_realloc(a->free_list, (a->isize += a->iresize), char);
-        memset((void *)(a->free_list + o), ~0, a->iresize);
-      }
-      a->mem = (void *)C_realloc(a->mem, (a->size += a->resize) * a->elemsz,
-                                 char);
-    }
-    dv = div((e = (a->bot)++), C_DARRAY_NBBY);
-    byte = dv.quot, bit = dv.rem;
+    if((a->bot == a->size) && ! __C_darray_grow(a))
+      return(NULL);
+    e = (a->bot)++;
   }
   else
   {
     a->del_count--;
-    for(byte = 0, bp = a->free_list; !*bp; byte++, bp++);
-    b = *bp;
-    for(bit = 0; bit < C_DARRAY_NBBY; bit++)
-    {
-      if(b & 1)
-        break;
-      b >>= 1;
-    }
-    e = C_DARRAY_NBBY * byte + bit;
+    e = __C_darray_find_free(a);
+    __C_darray_mark_used(a, e);
   }
   if(index) *index = e;
-  *(a->free_list + byte) &= C_DARRAY_USED_MASK(bit);
 
   return(memcpy((void *)(a->mem + (e * a->elemsz)), data, a->elemsz));
 }
@@ -132,16 +530,12 @@ void *C_darray_store(c_darray_t *a, const void *data, uint_t *index)
 
 void *C_darray_restore(c_darray_t *a, uint_t index)
 {
-  div_t dv;
-
   if(!a)
     return(NULL);
   if(index >= a->bot)
     return(NULL);
 
-  dv = div(index, C_DARRAY_NBBY);
-
-  return((*(a->free_list + dv.quot) & C_DARRAY_FREE_MASK(dv.rem))
+  return((a->free_map[index / __C_DARRAY_WORD_BITS] & __C_darray_bit(index))
          ? NULL : (void *)(a->mem + (index * a->elemsz)));
 }
 
@@ -150,19 +544,14 @@ void *C_darray_restore(c_darray_t *a, uint_t index)
 
 c_bool_t C_darray_delete(c_darray_t *a, uint_t index)
 {
-  div_t dv;
-  char *b;
-
   if(!a)
     return(FALSE);
   if(index >= a->bot)
     return(FALSE);
-  dv = div(index, C_DARRAY_NBBY);
-  b = (a->free_list + dv.quot);
-  if(*b & C_DARRAY_FREE_MASK(dv.rem))
+  if(a->free_map[index / __C_DARRAY_WORD_BITS] & __C_darray_bit(index))
     return(FALSE);
 
-  *b |= C_DARRAY_FREE_MASK(dv.rem);
+  __C_darray_mark_free(a, index);
   a->del_count++;
 
   return(TRUE);
@@ -175,6 +564,9 @@ c_darray_t *C_darray_load(const char *path)
 {
   FILE *fp;
   c_darray_t *a;
+  __c_darray_header_t hdr;
+  struct stat stbuf;
+  c_bool_t ok;
 
   if(!path)
     return(NULL);
@@ -183,34 +575,40 @@ c_darray_t *C_darray_load(const char *path)
   if(!(fp = fopen(path, "r")))
     return(NULL);
 
-  a = C_new(c_darray_t);
-  if(fread((void *)a, sizeof(c_darray_t), (size_t)1, fp) != 1)
+  if(fstat(fileno(fp), &stbuf)
+     || (fread((void *)&hdr, sizeof(hdr), (size_t)1, fp) != 1)
+     || !(a = __C_darray_get_header(&hdr, stbuf.st_size)))
   {
-    C_free(a);
     fclose(fp);
     return(NULL);
   }
 
-  a->free_list = C_newstr(a->isize);
-  if(fread((void *)a->free_list, sizeof(char), a->isize, fp) != a->isize)
+  /* only the free map is saved; the summary is rebuilt from it */
+
+  a->size = C_max(a->bot, a->resize);
+  a->mem = (void *)C_malloc((size_t)a->size * a->elemsz, char);
+  __C_darray_map_alloc(a);
+
+  ok = ((fread(a->mem, a->elemsz, a->bot, fp) == a->bot)
+        && ! fseek(fp, (long)__C_darray_map_offset(a), SEEK_SET)
+        && (fread((void *)a->free_map, sizeof(uint64_t),
+                  __C_darray_words(a->bot), fp)
+            == __C_darray_words(a->bot)));
+
+  fclose(fp);
+
+  if(ok)
   {
-    fclose(fp);
-    C_free(a->free_list);
-    C_free(a);
-    return(NULL);
+    __C_darray_rebuild_summary(a);
+    ok = (__C_darray_checksum(a) == hdr.checksum);
   }
 
-  a->mem = (void *)C_malloc(a->size * a->elemsz, char);
-  if(fread(a->mem, a->elemsz, a->size, fp) != a->size)
+  if(! ok)
   {
-    fclose(fp);
-    C_free(a->free_list);
-    C_free(a->mem);
-    C_free(a);
+    C_darray_destroy(a);
     return(NULL);
   }
 
-  fclose(fp);
   return(a);
 }
 
@@ -220,6 +618,10 @@ c_darray_t *C_darray_load(const char *path)
 c_bool_t C_darray_save(c_darray_t *a, const char *path)
 {
   FILE *fp;
+  __c_darray_header_t hdr;
+  static const char pad[8] = { 0 };
+  size_t padlen;
+  c_bool_t ok;
 
   if(!a || !path)
     return(FALSE);
@@ -228,26 +630,104 @@ c_bool_t C_darray_save(c_darray_t *a, const char *path)
   if(!(fp = fopen(path, "w")))
     return(FALSE);
 
-  if(fwrite((void *)a, sizeof(c_darray_t), (size_t)1, fp) != 1)
+  __C_darray_put_header(a, &hdr);
+  padlen = __C_darray_map_offset(a) - __C_DARRAY_DATA_OFFSET
+    - ((size_t)a->bot * a->elemsz);
+
+  ok = ((fwrite((void *)&hdr, sizeof(hdr), (size_t)1, fp) == 1)
+        && (fwrite(a->mem, a->elemsz, a->bot, fp) == a->bot)
+        && (fwrite(pad, (size_t)1, padlen, fp) == padlen)
+        && (fwrite((void *)a->free_map, sizeof(uint64_t),
+                   __C_darray_words(a->bot), fp)
+            == __C_darray_words(a->bot)));
+
+  if(fclose(fp))
+    ok = FALSE;
+
+  return(ok);
+}
+
+/*
+ */
+
+c_darray_t *C_darray_map(const char *path, int flags)
+{
+  c_memfile_t *mf;
+  c_darray_t *a;
+
+  if(!path)
+    return(NULL);
+
+  if(!(mf = C_memfile_open_flags(path, ((flags & C_DARRAY_MAP_PRIVATE)
+                                         ? C_MEMFILE_PRIVATE : 0))))
+    return(NULL);
+
+  if((C_memfile_length(mf) < (off_t)sizeof(__c_darray_header_t))
+     || !(a = __C_darray_get_header(
+            (const __c_darray_header_t *)C_memfile_base(mf),
+            C_memfile_length(mf))))
   {
-    fclose(fp);
-    return(FALSE);
+    C_memfile_close(mf);
+    return(NULL);
   }
 
-  if(fwrite((void *)a->free_list, sizeof(char), a->isize, fp) != a->isize)
+  /* The elements are used in place; only the free map is copied, and
+     only if there are deleted slots to be found in it. */
+
+  a->file = mf;
+  a->mem = C_memfile_pointer(mf, __C_DARRAY_DATA_OFFSET);
+  a->size = __C_darray_file_capacity(a);
+  __C_darray_map_alloc(a);
+
+  if(a->del_count)
   {
-    fclose(fp);
-    return(FALSE);
+    memcpy(a->free_map, C_memfile_pointer(mf, __C_darray_map_offset(a)),
+           __C_darray_map_bytes(a));
+    __C_darray_rebuild_summary(a);
   }
 
-  if(fwrite(a->mem, a->elemsz, a->size, fp) != a->size)
+  if((flags & C_DARRAY_MAP_VERIFY)
+     && (__C_darray_checksum(a) != ((const __c_darray_header_t *)
+                                    C_memfile_base(mf))->checksum))
   {
-    fclose(fp);
+    C_memfile_close(mf);
+    __C_darray_free(a);
+    return(NULL);
+  }
+
+  return(a);
+}
+
+/*
+ */
+
+c_bool_t C_darray_sync(c_darray_t *a)
+{
+  size_t mapoff, mapbytes;
+
+  if(!a || !a->file || (a->file->flags & C_MEMFILE_PRIVATE))
     return(FALSE);
+
+  /* write the free map after the last element, extending the file if the
+     map does not fit there */
+
+  mapoff = __C_darray_map_offset(a);
+  mapbytes = __C_darray_map_bytes(a);
+
+  if((off_t)(mapoff + mapbytes) > C_memfile_length(a->file))
+  {
+    if(! C_memfile_resize(a->file, (off_t)(mapoff + mapbytes)))
+      return(FALSE);
+
+    a->mem = C_memfile_pointer(a->file, __C_DARRAY_DATA_OFFSET);
+    a->size = __C_darray_file_capacity(a);
+    __C_darray_map_alloc(a);
   }
 
-  fclose(fp);
-  return(TRUE);
+  memcpy(C_memfile_pointer(a->file, mapoff), a->free_map, mapbytes);
+  __C_darray_put_header(a, (__c_darray_header_t *)C_memfile_base(a->file));
+
+  return(C_memfile_sync(a->file, FALSE));
 }
 
 /*
@@ -262,7 +742,9 @@ c_darray_t *C_darray_defragment(c_darray_t *a)
   if(!a) return(NULL);
   if(!a->del_count) return(a);
 
-  n = C_darray_create(a->resize, a->elemsz);
+  n = C_darray_create(a->iresize, a->elemsz);
+  n->growth = a->growth;
+  C_darray_reserve(n, C_darray_size(a));
   for(i = 0; i < a->bot; i++)
     if((e = C_darray_restore(a, i)))
       C_darray_store(n, e, NULL);
@@ -279,35 +761,91 @@ c_bool_t C_darray_iterate(c_darray_t *a,
                                            void *hook),
                           uint_t index, void *hook)
 {
-  char *byp, by, bil;
-  div_t dv;
-  uint_t i, left;
-  void *e;
-
   if(!a || !iter)
     return(FALSE);
-  if(a->bot < index)
+  if(a->bot <= index)
     return(TRUE);
-  dv = div(index, C_DARRAY_NBBY);
-
-  for(e = a->mem + (a->elemsz * index),
-        byp = a->free_list + dv.quot,
-        i = 0,
-        left = a->bot - index,
-        bil = C_DARRAY_NBBY - dv.rem,
-        by = *byp >> dv.rem;
-      left--;
-      i++, e += a->elemsz)
+
+  return(__C_darray_iterate_range(a, iter, index, a->bot, hook, NULL));
+}
+
+/*
+ */
+
+c_bool_t C_darray_iterate_parallel(c_darray_t *a,
+                                   c_bool_t (*iter)(void *elem, uint_t index,
+                                                    void *hook),
+                                   uint_t nworkers, void **hooks,
+                                   void (*reduce)(void *hook, void *result),
+                                   void *result)
+{
+  __c_darray_worker_t *workers, *w;
+  uint_t i, per;
+  int stop = 0;
+  c_bool_t ok = TRUE;
+
+  if(!a || !iter || (nworkers < 1))
+    return(FALSE);
+
+  /* Divide the array into contiguous ranges of whole free map words, so
+     that no word is read by more than one worker. */
+
+  per = (__C_darray_words(a->bot) + nworkers - 1) / nworkers;
+  workers = C_newa(nworkers, __c_darray_worker_t);
+
+  for(i = 0, w = workers; i < nworkers; ++i, ++w)
   {
-    if(!(by & 1))
-      if(!iter(e, i, hook))
-        return(FALSE);
+    w->a = a;
+    w->iter = iter;
+    w->from = (uint_t)C_min((uint64_t)i * per * __C_DARRAY_WORD_BITS,
+                            (uint64_t)a->bot);
+    w->to = (uint_t)C_min((uint64_t)(i + 1) * per * __C_DARRAY_WORD_BITS,
+                          (uint64_t)a->bot);
+    w->hook = (hooks ? hooks[i] : NULL);
+    w->stop = &stop;
+    w->result = TRUE;
+  }
+
+#ifdef THREADED_LIBRARY
 
-    if(!--bil)
-      bil = C_DARRAY_NBBY, by = *(byp++);
+  /* the calling thread takes the first range itself */
+
+  for(i = 1, w = workers + 1; i < nworkers; ++i, ++w)
+  {
+    w->started = ((w->from < w->to)
+                  && ! pthread_create(&(w->thread), NULL, __C_darray_worker,
+                                      (void *)w));
+    if(! w->started)
+      __C_darray_worker((void *)w);
   }
 
-  return(TRUE);
+  __C_darray_worker((void *)workers);
+
+  for(i = 1, w = workers + 1; i < nworkers; ++i, ++w)
+  {
+    if(w->started)
+      pthread_join(w->thread, NULL);
+  }
+
+#else
+
+  for(i = 0, w = workers; i < nworkers; ++i, ++w)
+    __C_darray_worker((void *)w);
+
+#endif /* THREADED_LIBRARY */
+
+  for(i = 0, w = workers; i < nworkers; ++i, ++w)
+  {
+    if(! w->result)
+      ok = FALSE;
+
+    if(reduce)
+      reduce(w->hook, result);
+  }
+
+  C_free(workers);
+
+  return(ok);
 }
 
 /* end of source file */
@@ -0,0 +1,1098 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_DBTREE_MAGIC "cbaseBT"
+#define __C_DBTREE_VERSION 1
+
+#define __C_DBTREE_MIN_PAGESIZE 512
+#define __C_DBTREE_MAX_PAGESIZE 65536
+#define __C_DBTREE_MIN_KEYS 4
+
+/* number of pages in a newly created file, including the header page */
+
+#define __C_DBTREE_INITIAL_PAGES 16
+
+#define __C_DBTREE_LEAF 1
+#define __C_DBTREE_INTERIOR 2
+#define __C_DBTREE_FREE 3
+
+#define __C_DBTREE_INSERTED 0
+#define __C_DBTREE_DUPLICATE 1
+#define __C_DBTREE_SPLIT 2
+#define __C_DBTREE_DELETED 3
+#define __C_DBTREE_UNDERFLOW 4
+#define __C_DBTREE_NOTFOUND 5
+
+/* Page 0 holds the file header; pages are numbered from 1, and page
+   number 0 stands for no page. Every page begins with a page header, and
+   is followed by its keys, stored contiguously. A leaf's keys are
+   followed by its values, each padded to a multiple of 8 bytes, and an
+   interior page's keys by its child page numbers. Everything is stored
+   in native byte order. */
+
+typedef struct __c_dbtree_header_t
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t pagesize;
+  uint32_t valsize;
+  uint32_t height;
+  uint64_t root;
+  uint64_t npages;
+  uint64_t freelist;
+  uint64_t count;
+} __c_dbtree_header_t;
+
+typedef struct __c_dbtree_page_t
+{
+  uint32_t type;
+  uint32_t count;
+  uint64_t next; /* right sibling of a leaf, or next free page */
+  uint64_t prev; /* left sibling of a leaf */
+  uint64_t reserved;
+} __c_dbtree_page_t;
+
+#define __C_dbtree_header(T)                                    \
+  ((__c_dbtree_header_t *)C_memfile_base((T)->file))
+
+#define __C_dbtree_page(T, N)                                           \
+  ((__c_dbtree_page_t *)((char *)C_memfile_base((T)->file)              \
+                         + ((size_t)(N) * (T)->pagesize)))
+
+#define __C_dbtree_keys(P)                      \
+  ((c_id_t *)((P) + 1))
+
+#define __C_dbtree_value(T, P, I)                               \
+  ((char *)(__C_dbtree_keys(P) + (T)->lcap)                     \
+   + ((size_t)(I) * (T)->vstride))
+
+#define __C_dbtree_children(T, P)               \
+  ((uint64_t *)(__C_dbtree_keys(P) + (T)->icap))
+
+#define __C_dbtree_stride(V)                    \
+  (((V) + 7) & ~7U)
+
+#define __C_dbtree_leaf_capacity(S, V)                                  \
+  (((S) - sizeof(__c_dbtree_page_t)) / (sizeof(c_id_t) + __C_dbtree_stride(V)))
+
+#define __C_dbtree_interior_capacity(S)                                 \
+  (((S) - sizeof(__c_dbtree_page_t) - sizeof(uint64_t))                 \
+   / (sizeof(c_id_t) + sizeof(uint64_t)))
+
+/* File scope functions */
+
+static uint_t __C_dbtree_search(const c_id_t *keys, uint_t n, c_id_t key)
+{
+  const c_id_t *base = keys;
+  uint_t half;
+
+  /* Returns the index of the first key not less than key. */
+
+  if(n == 0)
+    return(0);
+
+  while(n > 1)
+  {
+    half = n >> 1;
+    base = (base[half] < key) ? (base + half) : base;
+    n -= half;
+  }
+
+  return((uint_t)(base - keys) + (*base < key));
+}
+
+/*
+ */
+
+static uint_t __C_dbtree_child(const c_id_t *keys, uint_t n, c_id_t key)
+{
+  uint_t i;
+
+  /* A separator is the smallest key in the subtree to its right, so the
+     key belongs in the child after the last separator not greater than
+     it. */
+
+  i = __C_dbtree_search(keys, n, key);
+
+  if((i < n) && (keys[i] == key))
+    ++i;
+
+  return(i);
+}
+
+/*
+ */
+
+static c_bool_t __C_dbtree_valid_geometry(uint_t pagesize, uint_t valsize)
+{
+  if((pagesize < __C_DBTREE_MIN_PAGESIZE)
+     || (pagesize > __C_DBTREE_MAX_PAGESIZE)
+     || (pagesize & (pagesize - 1)))
+    return(FALSE);
+
+  if(valsize > pagesize)
+    return(FALSE);
+
+  return(__C_dbtree_leaf_capacity(pagesize, valsize) >= __C_DBTREE_MIN_KEYS);
+}
+
+/*
+ */
+
+static c_dbtree_t *__C_dbtree_init(c_memfile_t *mf, c_bool_t readonly)
+{
+  c_dbtree_t *tree;
+  const __c_dbtree_header_t *hdr;
+
+  hdr = (const __c_dbtree_header_t *)C_memfile_base(mf);
+
+  tree = C_new(c_dbtree_t);
+  tree->file = mf;
+  tree->readonly = readonly;
+  tree->pagesize = hdr->pagesize;
+  tree->valsize = hdr->valsize;
+  tree->vstride = __C_dbtree_stride(hdr->valsize);
+  tree->lcap = __C_dbtree_leaf_capacity(hdr->pagesize, hdr->valsize);
+  tree->icap = __C_dbtree_interior_capacity(hdr->pagesize);
+
+  /* room for an overfull interior page while it is being split */
+
+  tree->scratch = C_malloc(((tree->icap + 1) * sizeof(c_id_t))
+                           + ((tree->icap + 2) * sizeof(uint64_t)), char);
+
+  return(tree);
+}
+
+/*
+ */
+
+static c_bool_t __C_dbtree_reserve(c_dbtree_t *tree, uint_t n)
+{
+  __c_dbtree_header_t *hdr = __C_dbtree_header(tree);
+  off_t needed, length;
+
+  /* Makes room in the file for n more pages, so that the pages
+     allocated during a single insertion never move the mapping. The
+     file is grown geometrically, to keep remapping rare. */
+
+  needed = (off_t)((hdr->npages + n) * tree->pagesize);
+  length = C_memfile_length(tree->file);
+
+  if(needed <= length)
+    return(TRUE);
+
+  if(needed < (length * 2))
+    needed = length * 2;
+
+  return(C_memfile_resize(tree->file, needed));
+}
+
+/*
+ */
+
+static uint64_t __C_dbtree_alloc_page(c_dbtree_t *tree, uint32_t type)
+{
+  __c_dbtree_header_t *hdr = __C_dbtree_header(tree);
+  __c_dbtree_page_t *page;
+  uint64_t pgno;
+
+  /* reuse a freed page if there is one; the caller has reserved space in
+     the file otherwise */
+
+  if(hdr->freelist)
+  {
+    pgno = hdr->freelist;
+    hdr->freelist = __C_dbtree_page(tree, pgno)->next;
+  }
+  else
+    pgno = hdr->npages++;
+
+  page = __C_dbtree_page(tree, pgno);
+  C_zero(page, __c_dbtree_page_t);
+  page->type = type;
+
+  return(pgno);
+}
+
+/*
+ */
+
+static void __C_dbtree_free_page(c_dbtree_t *tree, uint64_t pgno)
+{
+  __c_dbtree_header_t *hdr = __C_dbtree_header(tree);
+  __c_dbtree_page_t *page = __C_dbtree_page(tree, pgno);
+
+  page->type = __C_DBTREE_FREE;
+  page->count = 0;
+  page->prev = 0;
+  page->next = hdr->freelist;
+  hdr->freelist = pgno;
+}
+
+/*
+ */
+
+static void __C_dbtree_leaf_insert(c_dbtree_t *tree, __c_dbtree_page_t *page,
+                                   uint_t i, c_id_t key, const void *value)
+{
+  c_id_t *keys = __C_dbtree_keys(page);
+
+  memmove(keys + i + 1, keys + i, (page->count - i) * sizeof(c_id_t));
+  memmove(__C_dbtree_value(tree, page, i + 1), __C_dbtree_value(tree, page, i),
+          (page->count - i) * tree->vstride);
+
+  keys[i] = key;
+
+  if(value)
+    memcpy(__C_dbtree_value(tree, page, i), value, tree->valsize);
+  else
+    memset(__C_dbtree_value(tree, page, i), 0, tree->valsize);
+
+  ++page->count;
+}
+
+/*
+ */
+
+static void __C_dbtree_leaf_remove(c_dbtree_t *tree, __c_dbtree_page_t *page,
+                                   uint_t i)
+{
+  c_id_t *keys = __C_dbtree_keys(page);
+
+  --page->count;
+
+  memmove(keys + i, keys + i + 1, (page->count - i) * sizeof(c_id_t));
+  memmove(__C_dbtree_value(tree, page, i), __C_dbtree_value(tree, page, i + 1),
+          (page->count - i) * tree->vstride);
+}
+
+/*
+ */
+
+static void __C_dbtree_leaf_move(c_dbtree_t *tree, __c_dbtree_page_t *dst,
+                                 uint_t di, __c_dbtree_page_t *src,
+                                 uint_t si, uint_t n)
+{
+  memmove(__C_dbtree_keys(dst) + di, __C_dbtree_keys(src) + si,
+          n * sizeof(c_id_t));
+  memmove(__C_dbtree_value(tree, dst, di), __C_dbtree_value(tree, src, si),
+          n * tree->vstride);
+}
+
+/*
+ */
+
+static int __C_dbtree_insert_page(c_dbtree_t *tree, uint64_t pgno, c_id_t key,
+                                  const void *value, c_id_t *rkey,
+                                  uint64_t *rpage)
+{
+  __c_dbtree_page_t *page = __C_dbtree_page(tree, pgno), *right;
+  c_id_t *keys = __C_dbtree_keys(page), *tkeys;
+  uint64_t *children, *tchildren, newpg;
+  uint_t i, m, n;
+  int r;
+
+  if(page->type == __C_DBTREE_LEAF)
+  {
+    i = __C_dbtree_search(keys, page->count, key);
+
+    if((i < page->count) && (keys[i] == key))
+      return(__C_DBTREE_DUPLICATE);
+
+    if(page->count < tree->lcap)
+    {
+      __C_dbtree_leaf_insert(tree, page, i, key, value);
+      return(__C_DBTREE_INSERTED);
+    }
+
+    /* split the leaf, moving its upper half to a new right sibling, and
+       insert the new item into whichever half it falls in */
+
+    newpg = __C_dbtree_alloc_page(tree, __C_DBTREE_LEAF);
+    right = __C_dbtree_page(tree, newpg);
+
+    m = (tree->lcap + 1) / 2;
+
+    if(i < m)
+    {
+      n = page->count - (m - 1);
+      __C_dbtree_leaf_move(tree, right, 0, page, m - 1, n);
+      right->count = n;
+      page->count = m - 1;
+      __C_dbtree_leaf_insert(tree, page, i, key, value);
+    }
+    else
+    {
+      n = page->count - m;
+      __C_dbtree_leaf_move(tree, right, 0, page, m, n);
+      right->count = n;
+      page->count = m;
+      __C_dbtree_leaf_insert(tree, right, i - m, key, value);
+    }
+
+    right->next = page->next;
+    right->prev = pgno;
+
+    if(page->next)
+      __C_dbtree_page(tree, page->next)->prev = newpg;
+
+    page->next = newpg;
+
+    *rkey = __C_dbtree_keys(right)[0];
+    *rpage = newpg;
+
+    return(__C_DBTREE_SPLIT);
+  }
+
+  children = __C_dbtree_children(tree, page);
+  i = __C_dbtree_child(keys, page->count, key);
+
+  r = __C_dbtree_insert_page(tree, children[i], key, value, rkey, rpage);
+
+  if(r != __C_DBTREE_SPLIT)
+    return(r);
+
+  /* the child split; add the new separator and right child here */
+
+  if(page->count < tree->icap)
+  {
+    memmove(keys + i + 1, keys + i, (page->count - i) * sizeof(c_id_t));
+    memmove(children + i + 2, children + i + 1,
+            (page->count - i) * sizeof(uint64_t));
+
+    keys[i] = *rkey;
+    children[i + 1] = *rpage;
+    ++page->count;
+
+    return(__C_DBTREE_INSERTED);
+  }
+
+  /* This page is full too. Assemble the overfull key and child arrays in
+     the scratch buffer, then divide them between this page and a new
+     right sibling, passing the middle key up. */
+
+  tkeys = (c_id_t *)tree->scratch;
+  tchildren = (uint64_t *)(tkeys + tree->icap + 1);
+
+  memcpy(tkeys, keys, i * sizeof(c_id_t));
+  tkeys[i] = *rkey;
+  memcpy(tkeys + i + 1, keys + i, (page->count - i) * sizeof(c_id_t));
+
+  memcpy(tchildren, children, (i + 1) * sizeof(uint64_t));
+  tchildren[i + 1] = *rpage;
+  memcpy(tchildren + i + 2, children + i + 1,
+         (page->count - i) * sizeof(uint64_t));
+
+  newpg = __C_dbtree_alloc_page(tree, __C_DBTREE_INTERIOR);
+  right = __C_dbtree_page(tree, newpg);
+
+  n = tree->icap + 1;
+  m = n / 2;
+
+  memcpy(keys, tkeys, m * sizeof(c_id_t));
+  memcpy(children, tchildren, (m + 1) * sizeof(uint64_t));
+  page->count = m;
+
+  memcpy(__C_dbtree_keys(right), tkeys + m + 1, (n - m - 1) * sizeof(c_id_t));
+  memcpy(__C_dbtree_children(tree, right), tchildren + m + 1,
+         (n - m) * sizeof(uint64_t));
+  right->count = n - m - 1;
+
+  *rkey = tkeys[m];
+  *rpage = newpg;
+
+  return(__C_DBTREE_SPLIT);
+}
+
+/*
+ */
+
+static void __C_dbtree_rebalance(c_dbtree_t *tree, __c_dbtree_page_t *parent,
+                                 uint_t i)
+{
+  c_id_t *pkeys = __C_dbtree_keys(parent), *lkeys, *rkeys;
+  uint64_t *pchildren = __C_dbtree_children(tree, parent), *lchildren,
+    *rchildren, rpgno;
+  __c_dbtree_page_t *left, *right;
+  uint_t s, min, lc, rc;
+
+  /* Child i has underflowed. Borrow an item from its left sibling, or
+     from its right sibling if it has no left one; if the sibling has none
+     to spare, merge the two. s is the index of the separator between
+     them. */
+
+  s = (i > 0) ? (i - 1) : 0;
+  left = __C_dbtree_page(tree, pchildren[s]);
+  right = __C_dbtree_page(tree, pchildren[s + 1]);
+  lkeys = __C_dbtree_keys(left);
+  rkeys = __C_dbtree_keys(right);
+  lc = left->count;
+  rc = right->count;
+
+  if(left->type == __C_DBTREE_LEAF)
+  {
+    min = tree->lcap / 2;
+
+    if((i > 0) && (lc > min))
+    {
+      __C_dbtree_leaf_insert(tree, right, 0, lkeys[lc - 1],
+                             __C_dbtree_value(tree, left, lc - 1));
+      --left->count;
+      pkeys[s] = rkeys[0];
+      return;
+    }
+
+    if((i == 0) && (rc > min))
+    {
+      __C_dbtree_leaf_insert(tree, left, lc, rkeys[0],
+                             __C_dbtree_value(tree, right, 0));
+      __C_dbtree_leaf_remove(tree, right, 0);
+      pkeys[s] = rkeys[0];
+      return;
+    }
+
+    __C_dbtree_leaf_move(tree, left, lc, right, 0, rc);
+    left->count = lc + rc;
+    left->next = right->next;
+
+    if(right->next)
+      __C_dbtree_page(tree, right->next)->prev = pchildren[s];
+  }
+  else
+  {
+    min = tree->icap / 2;
+    lchildren = __C_dbtree_children(tree, left);
+    rchildren = __C_dbtree_children(tree, right);
+
+    if((i > 0) && (lc > min))
+    {
+      memmove(rkeys + 1, rkeys, rc * sizeof(c_id_t));
+      memmove(rchildren + 1, rchildren, (rc + 1) * sizeof(uint64_t));
+      rkeys[0] = pkeys[s];
+      rchildren[0] = lchildren[lc];
+      pkeys[s] = lkeys[lc - 1];
+      --left->count;
+      ++right->count;
+      return;
+    }
+
+    if((i == 0) && (rc > min))
+    {
+      lkeys[lc] = pkeys[s];
+      lchildren[lc + 1] = rchildren[0];
+      pkeys[s] = rkeys[0];
+      memmove(rkeys, rkeys + 1, (rc - 1) * sizeof(c_id_t));
+      memmove(rchildren, rchildren + 1, rc * sizeof(uint64_t));
+      ++left->count;
+      --right->count;
+      return;
+    }
+
+    lkeys[lc] = pkeys[s];
+    memcpy(lkeys + lc + 1, rkeys, rc * sizeof(c_id_t));
+    memcpy(lchildren + lc + 1, rchildren, (rc + 1) * sizeof(uint64_t));
+    left->count = lc + rc + 1;
+  }
+
+  /* the right page was merged into the left; drop it from the parent */
+
+  rpgno = pchildren[s + 1];
+
+  memmove(pkeys + s, pkeys + s + 1, (parent->count - s - 1) * sizeof(c_id_t));
+  memmove(pchildren + s + 1, pchildren + s + 2,
+          (parent->count - s - 1) * sizeof(uint64_t));
+  --parent->count;
+
+  __C_dbtree_free_page(tree, rpgno);
+}
+
+/*
+ */
+
+static int __C_dbtree_delete_page(c_dbtree_t *tree, uint64_t pgno, c_id_t key)
+{
+  __c_dbtree_page_t *page = __C_dbtree_page(tree, pgno);
+  c_id_t *keys = __C_dbtree_keys(page);
+  uint_t i;
+  int r;
+
+  if(page->type == __C_DBTREE_LEAF)
+  {
+    i = __C_dbtree_search(keys, page->count, key);
+
+    if((i == page->count) || (keys[i] != key))
+      return(__C_DBTREE_NOTFOUND);
+
+    __C_dbtree_leaf_remove(tree, page, i);
+
+    return((page->count < (tree->lcap / 2))
+           ? __C_DBTREE_UNDERFLOW : __C_DBTREE_DELETED);
+  }
+
+  i = __C_dbtree_child(keys, page->count, key);
+
+  r = __C_dbtree_delete_page(tree, __C_dbtree_children(tree, page)[i], key);
+
+  if(r != __C_DBTREE_UNDERFLOW)
+    return(r);
+
+  __C_dbtree_rebalance(tree, page, i);
+
+  return((page->count < (tree->icap / 2))
+         ? __C_DBTREE_UNDERFLOW : __C_DBTREE_DELETED);
+}
+
+/*
+ */
+
+static __c_dbtree_page_t *__C_dbtree_find_leaf(c_dbtree_t *tree, c_id_t key,
+                                               uint64_t *pgno)
+{
+  __c_dbtree_page_t *page;
+  uint64_t n = __C_dbtree_header(tree)->root;
+
+  if(!n)
+    return(NULL);
+
+  for(page = __C_dbtree_page(tree, n); page->type == __C_DBTREE_INTERIOR;
+      page = __C_dbtree_page(tree, n))
+  {
+    n = __C_dbtree_children(tree, page)[
+      __C_dbtree_child(__C_dbtree_keys(page), page->count, key)];
+  }
+
+  if(pgno)
+    *pgno = n;
+
+  return(page);
+}
+
+/*
+ */
+
+static uint64_t __C_dbtree_edge_leaf(c_dbtree_t *tree, c_bool_t last)
+{
+  __c_dbtree_page_t *page;
+  uint64_t n = __C_dbtree_header(tree)->root;
+
+  if(!n)
+    return(0);
+
+  for(page = __C_dbtree_page(tree, n); page->type == __C_DBTREE_INTERIOR;
+      page = __C_dbtree_page(tree, n))
+  {
+    n = __C_dbtree_children(tree, page)[last ? page->count : 0];
+  }
+
+  return(n);
+}
+
+/*
+ */
+
+static c_bool_t __C_dbtree_cursor_settle(c_dbtree_cursor_t *cursor)
+{
+  __c_dbtree_page_t *page;
+
+  /* a position past the end of a leaf is the start of the next one */
+
+  while(cursor->page)
+  {
+    page = __C_dbtree_page(cursor->tree, cursor->page);
+
+    if(cursor->pos < page->count)
+      return(TRUE);
+
+    cursor->page = page->next;
+    cursor->pos = 0;
+  }
+
+  return(FALSE);
+}
+
+/*
+ */
+
+static c_bool_t __C_dbtree_cursor_locate(c_dbtree_cursor_t *cursor,
+                                         c_id_t key)
+{
+  __c_dbtree_page_t *page;
+
+  if(!(page = __C_dbtree_find_leaf(cursor->tree, key, &(cursor->page))))
+  {
+    cursor->page = 0;
+    return(FALSE);
+  }
+
+  cursor->pos = __C_dbtree_search(__C_dbtree_keys(page), page->count, key);
+
+  return(__C_dbtree_cursor_settle(cursor));
+}
+
+/*
+ */
+
+static c_bool_t __C_dbtree_cursor_check(c_dbtree_cursor_t *cursor)
+{
+  /* an element at or beyond the limit ends the scan */
+
+  if(__C_dbtree_cursor_settle(cursor)
+     && (!cursor->limit || (C_dbtree_cursor_key(cursor) < cursor->limit)))
+    return(TRUE);
+
+  cursor->page = 0;
+
+  return(FALSE);
+}
+
+/* Functions */
+
+c_dbtree_t *C_dbtree_create(const char *file, uint_t pagesize, uint_t valsize)
+{
+  c_memfile_t *mf;
+  __c_dbtree_header_t *hdr;
+  int fd;
+
+  if(!file)
+    return(NULL);
+
+  if(pagesize == 0)
+    pagesize = C_DBTREE_DEFAULT_PAGESIZE;
+
+  if(! __C_dbtree_valid_geometry(pagesize, valsize))
+    return(NULL);
+
+  if((fd = open(file, (O_RDWR | O_CREAT | O_TRUNC), 0666)) < 0)
+    return(NULL);
+
+  if(ftruncate(fd, (off_t)pagesize * __C_DBTREE_INITIAL_PAGES))
+  {
+    close(fd);
+    unlink(file);
+    return(NULL);
+  }
+
+  close(fd);
+
+  if(!(mf = C_memfile_open(file, FALSE)))
+    return(NULL);
+
+  hdr = (__c_dbtree_header_t *)C_memfile_base(mf);
+  memcpy(hdr->magic, __C_DBTREE_MAGIC, sizeof(hdr->magic));
+  hdr->version = __C_DBTREE_VERSION;
+  hdr->pagesize = pagesize;
+  hdr->valsize = valsize;
+  hdr->height = 0;
+  hdr->root = 0;
+  hdr->npages = 1;
+  hdr->freelist = 0;
+  hdr->count = 0;
+
+  return(__C_dbtree_init(mf, FALSE));
+}
+
+/*
+ */
+
+c_dbtree_t *C_dbtree_open(const char *file, c_bool_t readonly)
+{
+  c_memfile_t *mf;
+  const __c_dbtree_header_t *hdr;
+
+  if(!(mf = C_memfile_open(file, readonly)))
+    return(NULL);
+
+  /* validate the header against the file, so that lookups need not */
+
+  hdr = (const __c_dbtree_header_t *)C_memfile_base(mf);
+
+  if((C_memfile_length(mf) < sizeof(__c_dbtree_header_t))
+     || memcmp(hdr->magic, __C_DBTREE_MAGIC, sizeof(hdr->magic))
+     || (hdr->version != __C_DBTREE_VERSION)
+     || ! __C_dbtree_valid_geometry(hdr->pagesize, hdr->valsize)
+     || (hdr->npages == 0)
+     || ((hdr->npages * hdr->pagesize) > (uint64_t)C_memfile_length(mf))
+     || (hdr->root >= hdr->npages)
+     || (hdr->freelist >= hdr->npages))
+  {
+    C_memfile_close(mf);
+    return(NULL);
+  }
+
+  return(__C_dbtree_init(mf, readonly));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_close(c_dbtree_t *tree)
+{
+  c_bool_t r;
+
+  if(!tree)
+    return(FALSE);
+
+  r = C_memfile_close(tree->file);
+  C_free(tree->scratch);
+  C_free(tree);
+
+  return(r);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_sync(c_dbtree_t *tree, c_bool_t async)
+{
+  if(!tree)
+    return(FALSE);
+
+  return(C_memfile_sync(tree->file, async));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_store(c_dbtree_t *tree, c_id_t key, const void *value)
+{
+  __c_dbtree_header_t *hdr;
+  __c_dbtree_page_t *page;
+  c_id_t rkey;
+  uint64_t rpage, pgno;
+  int r;
+
+  if(!tree || tree->readonly || !key)
+    return(FALSE);
+
+  /* an insertion allocates at most one page per level, plus a new root */
+
+  if(! __C_dbtree_reserve(tree, __C_dbtree_header(tree)->height + 1))
+    return(FALSE);
+
+  hdr = __C_dbtree_header(tree);
+
+  if(!hdr->root)
+  {
+    hdr->root = __C_dbtree_alloc_page(tree, __C_DBTREE_LEAF);
+    hdr->height = 1;
+  }
+
+  r = __C_dbtree_insert_page(tree, hdr->root, key, value, &rkey, &rpage);
+
+  if(r == __C_DBTREE_DUPLICATE)
+    return(FALSE);
+
+  if(r == __C_DBTREE_SPLIT)
+  {
+    /* the root split; grow the tree by one level */
+
+    pgno = __C_dbtree_alloc_page(tree, __C_DBTREE_INTERIOR);
+    page = __C_dbtree_page(tree, pgno);
+
+    __C_dbtree_keys(page)[0] = rkey;
+    __C_dbtree_children(tree, page)[0] = hdr->root;
+    __C_dbtree_children(tree, page)[1] = rpage;
+    page->count = 1;
+
+    hdr->root = pgno;
+    ++hdr->height;
+  }
+
+  ++hdr->count;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_dbtree_restore(c_dbtree_t *tree, c_id_t key)
+{
+  __c_dbtree_page_t *page;
+  c_id_t *keys;
+  uint_t i;
+
+  if(!tree || !key)
+    return(NULL);
+
+  if(!(page = __C_dbtree_find_leaf(tree, key, NULL)))
+    return(NULL);
+
+  keys = __C_dbtree_keys(page);
+  i = __C_dbtree_search(keys, page->count, key);
+
+  if((i < page->count) && (keys[i] == key))
+    return(__C_dbtree_value(tree, page, i));
+
+  return(NULL);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_delete(c_dbtree_t *tree, c_id_t key)
+{
+  __c_dbtree_header_t *hdr;
+  __c_dbtree_page_t *root;
+  uint64_t pgno;
+
+  if(!tree || tree->readonly || !key)
+    return(FALSE);
+
+  hdr = __C_dbtree_header(tree);
+
+  if(!hdr->root)
+    return(FALSE);
+
+  if(__C_dbtree_delete_page(tree, hdr->root, key) == __C_DBTREE_NOTFOUND)
+    return(FALSE);
+
+  --hdr->count;
+
+  /* the root is exempt from the minimum fill; shrink the tree when it
+     empties */
+
+  root = __C_dbtree_page(tree, hdr->root);
+
+  if(root->count == 0)
+  {
+    pgno = hdr->root;
+
+    if(root->type == __C_DBTREE_LEAF)
+      hdr->root = 0;
+    else
+      hdr->root = __C_dbtree_children(tree, root)[0];
+
+    --hdr->height;
+    __C_dbtree_free_page(tree, pgno);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_iterate(c_dbtree_t *tree,
+                          c_bool_t (*consumer)(c_id_t key, void *value,
+                                               void *hook),
+                          void *hook)
+{
+  __c_dbtree_page_t *page;
+  uint64_t n;
+  uint_t i;
+
+  if(!tree || !consumer)
+    return(FALSE);
+
+  /* visit the leaves in key order, along their sibling links */
+
+  for(n = __C_dbtree_edge_leaf(tree, FALSE); n; n = page->next)
+  {
+    page = __C_dbtree_page(tree, n);
+
+    for(i = 0; i < page->count; ++i)
+    {
+      if(! consumer(__C_dbtree_keys(page)[i], __C_dbtree_value(tree, page, i),
+                    hook))
+        return(FALSE);
+    }
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+size_t C_dbtree_size(c_dbtree_t *tree)
+{
+  if(!tree)
+    return(0);
+
+  return((size_t)__C_dbtree_header(tree)->count);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_init(c_dbtree_t *tree, c_dbtree_cursor_t *cursor)
+{
+  if(!tree || !cursor)
+    return(FALSE);
+
+  cursor->tree = tree;
+  cursor->page = 0;
+  cursor->pos = 0;
+  cursor->limit = 0;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_set_limit(c_dbtree_cursor_t *cursor, c_id_t limit)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->limit = limit;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_seek(c_dbtree_cursor_t *cursor, c_id_t key)
+{
+  if(!cursor)
+    return(FALSE);
+
+  __C_dbtree_cursor_locate(cursor, key);
+
+  return(__C_dbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_first(c_dbtree_cursor_t *cursor)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->page = __C_dbtree_edge_leaf(cursor->tree, FALSE);
+  cursor->pos = 0;
+
+  return(__C_dbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_last(c_dbtree_cursor_t *cursor)
+{
+  if(!cursor)
+    return(FALSE);
+
+  /* With a limit, the last element is the one before the first element
+     at or beyond the limit; if there is no such element, or no limit, it
+     is the last element in the tree. */
+
+  if(cursor->limit && __C_dbtree_cursor_locate(cursor, cursor->limit))
+    return(C_dbtree_cursor_prev(cursor));
+
+  if(!(cursor->page = __C_dbtree_edge_leaf(cursor->tree, TRUE)))
+    return(FALSE);
+
+  cursor->pos = __C_dbtree_page(cursor->tree, cursor->page)->count;
+
+  return(C_dbtree_cursor_prev(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_next(c_dbtree_cursor_t *cursor)
+{
+  if(!cursor || !cursor->page)
+    return(FALSE);
+
+  ++cursor->pos;
+
+  return(__C_dbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_dbtree_cursor_prev(c_dbtree_cursor_t *cursor)
+{
+  __c_dbtree_page_t *page;
+
+  if(!cursor)
+    return(FALSE);
+
+  while(cursor->page)
+  {
+    if(cursor->pos > 0)
+    {
+      --cursor->pos;
+      return(TRUE);
+    }
+
+    page = __C_dbtree_page(cursor->tree, cursor->page);
+
+    if((cursor->page = page->prev))
+      cursor->pos = __C_dbtree_page(cursor->tree, cursor->page)->count;
+  }
+
+  return(FALSE);
+}
+
+/*
+ */
+
+c_id_t C_dbtree_cursor_key(c_dbtree_cursor_t *cursor)
+{
+  if(!cursor || !cursor->page)
+    return(0);
+
+  return(__C_dbtree_keys(__C_dbtree_page(cursor->tree,
+                                         cursor->page))[cursor->pos]);
+}
+
+/*
+ */
+
+void *C_dbtree_cursor_value(c_dbtree_cursor_t *cursor)
+{
+  if(!cursor || !cursor->page)
+    return(NULL);
+
+  return(__C_dbtree_value(cursor->tree,
+                          __C_dbtree_page(cursor->tree, cursor->page),
+                          cursor->pos));
+}
+
+/* end of source file */
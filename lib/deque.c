@@ -0,0 +1,261 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <limits.h>
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_DEQUE_MIN_CAPACITY 16
+
+/* The items are kept in a circular buffer whose capacity is a power of
+   two, so that a logical index is mapped onto the buffer with a mask. */
+
+#define __C_deque_slot(D, I)                            \
+  ((D)->items[((D)->head + (I)) & ((D)->capacity - 1)])
+
+/* File scope functions */
+
+static c_bool_t __C_deque_grow(c_deque_t *d)
+{
+  uint_t cap = d->capacity, wrapped;
+
+  if(cap > (UINT_MAX >> 1))
+    return(FALSE);
+
+  d->items = C_realloc(d->items, cap * 2, void *);
+  d->capacity = cap * 2;
+
+  /* the items that had wrapped around to the front of the old buffer
+     are moved to follow the others, into the newly added half */
+
+  if(d->head + d->size > cap)
+  {
+    wrapped = d->head + d->size - cap;
+    memcpy(d->items + cap, d->items, wrapped * sizeof(void *));
+  }
+
+  return(TRUE);
+}
+
+/* Functions */
+
+c_deque_t *C_deque_create(uint_t capacity)
+{
+  c_deque_t *d;
+  uint_t cap;
+
+  if(capacity > (UINT_MAX >> 1))
+    return(NULL);
+
+  for(cap = __C_DEQUE_MIN_CAPACITY; cap < capacity; cap <<= 1);
+
+  d = C_new(c_deque_t);
+  d->items = C_newa(cap, void *);
+  d->capacity = cap;
+  d->head = 0;
+  d->size = 0;
+
+  return(d);
+}
+
+/*
+ */
+
+void C_deque_destroy(c_deque_t *d)
+{
+  uint_t i;
+
+  if(! d)
+    return;
+
+  if(d->destructor)
+  {
+    for(i = 0; i < d->size; ++i)
+      d->destructor(__C_deque_slot(d, i));
+  }
+
+  C_free(d->items);
+  C_free(d);
+}
+
+/*
+ */
+
+c_bool_t C_deque_set_destructor(c_deque_t *d, void (*destructor)(void *))
+{
+  if(! d)
+    return(FALSE);
+
+  d->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_deque_push_back(c_deque_t *d, const void *data)
+{
+  if(!d || !data)
+    return(FALSE);
+
+  if((d->size == d->capacity) && ! __C_deque_grow(d))
+    return(FALSE);
+
+  __C_deque_slot(d, d->size) = (void *)data;
+  ++d->size;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_deque_push_front(c_deque_t *d, const void *data)
+{
+  if(!d || !data)
+    return(FALSE);
+
+  if((d->size == d->capacity) && ! __C_deque_grow(d))
+    return(FALSE);
+
+  d->head = (d->head - 1) & (d->capacity - 1);
+  d->items[d->head] = (void *)data;
+  ++d->size;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_deque_pop_back(c_deque_t *d)
+{
+  if(!d || !d->size)
+    return(NULL);
+
+  --d->size;
+
+  return(__C_deque_slot(d, d->size));
+}
+
+/*
+ */
+
+void *C_deque_pop_front(c_deque_t *d)
+{
+  void *data;
+
+  if(!d || !d->size)
+    return(NULL);
+
+  data = d->items[d->head];
+  d->head = (d->head + 1) & (d->capacity - 1);
+  --d->size;
+
+  return(data);
+}
+
+/*
+ */
+
+void *C_deque_peek_back(c_deque_t *d)
+{
+  if(!d || !d->size)
+    return(NULL);
+
+  return(__C_deque_slot(d, d->size - 1));
+}
+
+/*
+ */
+
+void *C_deque_peek_front(c_deque_t *d)
+{
+  if(!d || !d->size)
+    return(NULL);
+
+  return(d->items[d->head]);
+}
+
+/*
+ */
+
+void *C_deque_get(c_deque_t *d, uint_t index)
+{
+  if(!d || (index >= d->size))
+    return(NULL);
+
+  return(__C_deque_slot(d, index));
+}
+
+/*
+ */
+
+c_bool_t C_deque_reserve(c_deque_t *d, uint_t capacity)
+{
+  if(! d)
+    return(FALSE);
+
+  while(d->capacity < capacity)
+  {
+    if(! __C_deque_grow(d))
+      return(FALSE);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void C_deque_clear(c_deque_t *d)
+{
+  uint_t i;
+
+  if(! d)
+    return;
+
+  if(d->destructor)
+  {
+    for(i = 0; i < d->size; ++i)
+      d->destructor(__C_deque_slot(d, i));
+  }
+
+  d->head = 0;
+  d->size = 0;
+}
+
+/* end of source file */
@@ -0,0 +1,976 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <sched.h>
+#include <string.h>
+#ifdef THREADED_LIBRARY
+#include <pthread.h>
+#endif /* THREADED_LIBRARY */
+
+/* Local headers */
+
+#include "hashcommon.h"
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+#include "cbase/util.h"
+
+/* Macros */
+
+/* Each level of the trie consumes 5 bits of the hash, so a branch node
+   has at most 32 children. */
+
+#define __C_HAMT_BITS 5
+#define __C_HAMT_FANOUT (1 << __C_HAMT_BITS)
+
+#define __C_hamt_index(V, S)                                    \
+  ((uint_t)((V) >> (S)) & (__C_HAMT_FANOUT - 1))
+
+#define __C_HAMT_LEAF      0
+#define __C_HAMT_BRANCH    1
+#define __C_HAMT_COLLISION 2
+
+/* Node and version reference counts are shared between threads in the
+   threaded library, since versions may share most of their nodes. */
+
+#ifdef THREADED_LIBRARY
+
+#define __C_hamt_incref(P)                                      \
+  __atomic_add_fetch(&((P)->refs), 1, __ATOMIC_RELAXED)
+#define __C_hamt_decref(P)                                      \
+  __atomic_sub_fetch(&((P)->refs), 1, __ATOMIC_ACQ_REL)
+
+#else
+
+#define __C_hamt_incref(P) (++((P)->refs))
+#define __C_hamt_decref(P) (--((P)->refs))
+
+#endif /* THREADED_LIBRARY */
+
+#ifdef __GNUC__
+#define __C_hamt_popcount(X) ((uint_t)__builtin_popcount(X))
+#else
+#define __C_hamt_popcount(X) __C_hamt_popcount_slow(X)
+#endif /* __GNUC__ */
+
+/* Every element of the trie, whether a leaf or an interior node, begins
+   with this header. */
+
+typedef struct __c_hamt_obj_t
+{
+  uint_t refs;
+  int kind;
+} __c_hamt_obj_t;
+
+typedef struct __c_hamt_leaf_t
+{
+  __c_hamt_obj_t obj;
+  uint64_t hash;
+  size_t keylen;
+  void *data;
+  char key[];
+} __c_hamt_leaf_t;
+
+/* A branch node holds one child for each bit set in its bitmap, in bit
+   order. A collision node holds two or more leaves whose hashes are
+   identical; it may appear at any depth. */
+
+typedef struct __c_hamt_node_t
+{
+  __c_hamt_obj_t obj;
+  uint32_t bitmap;
+  uint_t count;
+  uint64_t hash;
+  __c_hamt_obj_t *child[];
+} __c_hamt_node_t;
+
+#define __C_hamt_hash(O)                                        \
+  (((O)->kind == __C_HAMT_LEAF) ? ((__c_hamt_leaf_t *)(O))->hash  \
+   : ((__c_hamt_node_t *)(O))->hash)
+
+/* File scope functions */
+
+#ifndef __GNUC__
+
+static uint_t __C_hamt_popcount_slow(uint32_t x)
+{
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0F0F0F0F;
+
+  return((x * 0x01010101) >> 24);
+}
+
+/*
+ */
+
+#endif /* __GNUC__ */
+
+static __c_hamt_leaf_t *__C_hamt_leaf_create(const void *key, size_t len,
+                                             uint64_t hash, const void *data)
+{
+  __c_hamt_leaf_t *leaf;
+
+  /* the key is copied inline, with a terminating NUL */
+
+  leaf = (__c_hamt_leaf_t *)C_malloc(sizeof(__c_hamt_leaf_t) + len + 1,
+                                     char);
+  leaf->obj.refs = 1;
+  leaf->obj.kind = __C_HAMT_LEAF;
+  leaf->hash = hash;
+  leaf->keylen = len;
+  leaf->data = (void *)data;
+  memcpy(leaf->key, key, len);
+  leaf->key[len] = NUL;
+
+  return(leaf);
+}
+
+/*
+ */
+
+static __c_hamt_node_t *__C_hamt_node_create(int kind, uint_t count)
+{
+  __c_hamt_node_t *node;
+
+  node = (__c_hamt_node_t *)C_malloc(sizeof(__c_hamt_node_t)
+                                     + (count * sizeof(__c_hamt_obj_t *)),
+                                     char);
+  node->obj.refs = 1;
+  node->obj.kind = kind;
+  node->bitmap = 0;
+  node->count = count;
+  node->hash = 0;
+
+  return(node);
+}
+
+/*
+ */
+
+static void __C_hamt_release(__c_hamt_obj_t *obj, void (*destructor)(void *))
+{
+  __c_hamt_node_t *node;
+  __c_hamt_leaf_t *leaf;
+  uint_t i;
+
+  if(!obj || __C_hamt_decref(obj))
+    return;
+
+  if(obj->kind == __C_HAMT_LEAF)
+  {
+    leaf = (__c_hamt_leaf_t *)obj;
+
+    if(destructor && leaf->data)
+      destructor(leaf->data);
+  }
+  else
+  {
+    node = (__c_hamt_node_t *)obj;
+
+    for(i = 0; i < node->count; ++i)
+      __C_hamt_release(node->child[i], destructor);
+  }
+
+  C_free(obj);
+}
+
+/* Copies a node, taking a new reference on each of its children except
+   the one at index skip (pass node->count to skip none). The copy has
+   extra additional child slots following the copied ones, which the
+   caller must fill in or move into place. */
+
+static __c_hamt_node_t *__C_hamt_node_copy(__c_hamt_node_t *node,
+                                           uint_t skip, uint_t extra)
+{
+  __c_hamt_node_t *copy;
+  uint_t i;
+
+  copy = __C_hamt_node_create(node->obj.kind, node->count + extra);
+  copy->bitmap = node->bitmap;
+  copy->hash = node->hash;
+
+  for(i = 0; i < node->count; ++i)
+  {
+    copy->child[i] = node->child[i];
+    if(i != skip)
+      __C_hamt_incref(node->child[i]);
+  }
+
+  return(copy);
+}
+
+/* Builds the smallest subtree that holds both a and b, whose hashes
+   differ; takes ownership of both references. */
+
+static __c_hamt_obj_t *__C_hamt_merge(__c_hamt_obj_t *a, __c_hamt_obj_t *b,
+                                      uint_t shift)
+{
+  __c_hamt_node_t *node;
+  uint64_t ha = __C_hamt_hash(a), hb = __C_hamt_hash(b);
+  uint_t ia = __C_hamt_index(ha, shift), ib = __C_hamt_index(hb, shift);
+
+  if(ia == ib)
+  {
+    node = __C_hamt_node_create(__C_HAMT_BRANCH, 1);
+    node->bitmap = (uint32_t)1 << ia;
+    node->child[0] = __C_hamt_merge(a, b, shift + __C_HAMT_BITS);
+  }
+  else
+  {
+    node = __C_hamt_node_create(__C_HAMT_BRANCH, 2);
+    node->bitmap = ((uint32_t)1 << ia) | ((uint32_t)1 << ib);
+    node->child[0] = (ia < ib) ? a : b;
+    node->child[1] = (ia < ib) ? b : a;
+  }
+
+  return((__c_hamt_obj_t *)node);
+}
+
+/* Returns a new subtree which is obj with leaf added, replacing any leaf
+   with the same key. Takes ownership of leaf; obj is only borrowed. */
+
+static __c_hamt_obj_t *__C_hamt_insert(__c_hamt_obj_t *obj, uint_t shift,
+                                       __c_hamt_leaf_t *leaf,
+                                       c_bool_t *replaced)
+{
+  __c_hamt_node_t *node = (__c_hamt_node_t *)obj, *copy;
+  __c_hamt_leaf_t *old;
+  uint32_t bit;
+  uint_t i, pos;
+
+  if(!obj)
+    return((__c_hamt_obj_t *)leaf);
+
+  switch(obj->kind)
+  {
+    case __C_HAMT_LEAF:
+      old = (__c_hamt_leaf_t *)obj;
+
+      if(old->hash != leaf->hash)
+      {
+        __C_hamt_incref(obj);
+        return(__C_hamt_merge(obj, (__c_hamt_obj_t *)leaf, shift));
+      }
+
+      if((old->keylen == leaf->keylen)
+         && !memcmp(old->key, leaf->key, leaf->keylen))
+      {
+        *replaced = TRUE;
+        return((__c_hamt_obj_t *)leaf);
+      }
+
+      copy = __C_hamt_node_create(__C_HAMT_COLLISION, 2);
+      copy->hash = leaf->hash;
+      __C_hamt_incref(obj);
+      copy->child[0] = obj;
+      copy->child[1] = (__c_hamt_obj_t *)leaf;
+
+      return((__c_hamt_obj_t *)copy);
+
+    case __C_HAMT_COLLISION:
+      if(node->hash != leaf->hash)
+      {
+        __C_hamt_incref(obj);
+        return(__C_hamt_merge(obj, (__c_hamt_obj_t *)leaf, shift));
+      }
+
+      for(i = 0; i < node->count; ++i)
+      {
+        old = (__c_hamt_leaf_t *)node->child[i];
+        if((old->keylen == leaf->keylen)
+           && !memcmp(old->key, leaf->key, leaf->keylen))
+        {
+          *replaced = TRUE;
+          copy = __C_hamt_node_copy(node, i, 0);
+          copy->child[i] = (__c_hamt_obj_t *)leaf;
+          return((__c_hamt_obj_t *)copy);
+        }
+      }
+
+      copy = __C_hamt_node_copy(node, node->count, 1);
+      copy->child[node->count] = (__c_hamt_obj_t *)leaf;
+
+      return((__c_hamt_obj_t *)copy);
+
+    default:
+      bit = (uint32_t)1 << __C_hamt_index(leaf->hash, shift);
+      pos = __C_hamt_popcount(node->bitmap & (bit - 1));
+
+      if(node->bitmap & bit)
+      {
+        copy = __C_hamt_node_copy(node, pos, 0);
+        copy->child[pos] = __C_hamt_insert(node->child[pos],
+                                           shift + __C_HAMT_BITS, leaf,
+                                           replaced);
+      }
+      else
+      {
+        copy = __C_hamt_node_copy(node, node->count, 1);
+        memmove(&(copy->child[pos + 1]), &(copy->child[pos]),
+                (node->count - pos) * sizeof(__c_hamt_obj_t *));
+        copy->child[pos] = (__c_hamt_obj_t *)leaf;
+        copy->bitmap |= bit;
+      }
+
+      return((__c_hamt_obj_t *)copy);
+  }
+}
+
+/* Returns a copy of a node with the child at pos removed. */
+
+static __c_hamt_obj_t *__C_hamt_node_remove(__c_hamt_node_t *node,
+                                            uint_t pos, uint32_t bit)
+{
+  __c_hamt_node_t *copy;
+  uint_t i, j;
+
+  copy = __C_hamt_node_create(node->obj.kind, node->count - 1);
+  copy->bitmap = node->bitmap & ~bit;
+  copy->hash = node->hash;
+
+  for(i = j = 0; i < node->count; ++i)
+  {
+    if(i != pos)
+    {
+      copy->child[j++] = node->child[i];
+      __C_hamt_incref(node->child[i]);
+    }
+  }
+
+  return((__c_hamt_obj_t *)copy);
+}
+
+/* Returns a new subtree which is obj without the given key, or NULL if the
+   subtree becomes empty. Sets *found to FALSE (and returns NULL) if the
+   key is not present. A node left with a single leaf or collision node
+   is collapsed into that child, so that the trie stays canonical. */
+
+static __c_hamt_obj_t *__C_hamt_remove(__c_hamt_obj_t *obj, uint_t shift,
+                                       const void *key, size_t len,
+                                       uint64_t hash, c_bool_t *found)
+{
+  __c_hamt_node_t *node = (__c_hamt_node_t *)obj, *copy;
+  __c_hamt_leaf_t *leaf;
+  __c_hamt_obj_t *sub, *other;
+  uint32_t bit;
+  uint_t i, pos;
+
+  *found = FALSE;
+
+  if(!obj)
+    return(NULL);
+
+  switch(obj->kind)
+  {
+    case __C_HAMT_LEAF:
+      leaf = (__c_hamt_leaf_t *)obj;
+      if((leaf->hash == hash) && (leaf->keylen == len)
+         && !memcmp(leaf->key, key, len))
+        *found = TRUE;
+
+      return(NULL);
+
+    case __C_HAMT_COLLISION:
+      if(node->hash != hash)
+        return(NULL);
+
+      for(i = 0; i < node->count; ++i)
+      {
+        leaf = (__c_hamt_leaf_t *)node->child[i];
+        if((leaf->keylen == len) && !memcmp(leaf->key, key, len))
+        {
+          *found = TRUE;
+
+          if(node->count == 2)
+          {
+            other = node->child[1 - i];
+            __C_hamt_incref(other);
+            return(other);
+          }
+
+          return(__C_hamt_node_remove(node, i, 0));
+        }
+      }
+
+      return(NULL);
+
+    default:
+      bit = (uint32_t)1 << __C_hamt_index(hash, shift);
+      if(!(node->bitmap & bit))
+        return(NULL);
+
+      pos = __C_hamt_popcount(node->bitmap & (bit - 1));
+      sub = __C_hamt_remove(node->child[pos], shift + __C_HAMT_BITS, key, len,
+                            hash, found);
+      if(!*found)
+        return(NULL);
+
+      if(!sub)
+      {
+        if(node->count == 1)
+          return(NULL);
+
+        if(node->count == 2)
+        {
+          other = node->child[1 - pos];
+          if(other->kind != __C_HAMT_BRANCH)
+          {
+            __C_hamt_incref(other);
+            return(other);
+          }
+        }
+
+        return(__C_hamt_node_remove(node, pos, bit));
+      }
+
+      if((node->count == 1) && (sub->kind != __C_HAMT_BRANCH))
+        return(sub);
+
+      copy = __C_hamt_node_copy(node, pos, 0);
+      copy->child[pos] = sub;
+
+      return((__c_hamt_obj_t *)copy);
+  }
+}
+
+/*
+ */
+
+static c_bool_t __C_hamt_iterate(__c_hamt_obj_t *obj,
+                                 c_bool_t (*consumer)(const char *key,
+                                                      size_t len, void *data,
+                                                      void *hook),
+                                 void *hook)
+{
+  __c_hamt_node_t *node;
+  __c_hamt_leaf_t *leaf;
+  uint_t i;
+
+  if(obj->kind == __C_HAMT_LEAF)
+  {
+    leaf = (__c_hamt_leaf_t *)obj;
+    return(consumer(leaf->key, leaf->keylen, leaf->data, hook));
+  }
+
+  node = (__c_hamt_node_t *)obj;
+
+  for(i = 0; i < node->count; ++i)
+  {
+    if(!__C_hamt_iterate(node->child[i], consumer, hook))
+      return(FALSE);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static c_hamt_t *__C_hamt_version(c_hamt_t *t, __c_hamt_obj_t *root,
+                                  size_t size)
+{
+  c_hamt_t *v;
+
+  v = C_new(c_hamt_t);
+  v->root = root;
+  v->size = size;
+  v->refs = 1;
+  v->hashfunc = t->hashfunc;
+  v->seed = t->seed;
+  v->destructor = t->destructor;
+
+  return(v);
+}
+
+/* Replaces the current version of a reference; the caller must hold the
+   writer lock, and passes its reference to t to the holder. */
+
+static void __C_hamtref_swap(c_hamtref_t *r, c_hamt_t *t)
+{
+  c_hamt_t *old;
+#ifdef THREADED_LIBRARY
+  uint_t epoch;
+#endif /* THREADED_LIBRARY */
+
+  old = r->current;
+
+#ifdef THREADED_LIBRARY
+
+  __atomic_store_n(&(r->current), t, __ATOMIC_SEQ_CST);
+  epoch = __atomic_fetch_add(&(r->epoch), 1, __ATOMIC_SEQ_CST);
+
+  /* wait out the readers that may have loaded the old pointer */
+
+  while(__atomic_load_n(&(r->readers[epoch & 1]), __ATOMIC_ACQUIRE))
+    sched_yield();
+
+#else
+
+  r->current = t;
+
+#endif /* THREADED_LIBRARY */
+
+  C_hamt_release(old);
+}
+
+/* Functions */
+
+c_hamt_t *C_hamt_create(int flags)
+{
+  c_hamt_t *t;
+
+  t = C_new(c_hamt_t);
+  t->root = NULL;
+  t->size = 0;
+  t->refs = 1;
+  t->hashfunc = C_string_hash64_len;
+
+  if(flags & C_HASHTABLE_RANDOM_SEED)
+    t->seed = __C_hashtable_random_seed();
+
+  return(t);
+}
+
+/*
+ */
+
+c_hamt_t *C_hamt_retain(c_hamt_t *t)
+{
+  if(t)
+    __C_hamt_incref(t);
+
+  return(t);
+}
+
+/*
+ */
+
+void C_hamt_release(c_hamt_t *t)
+{
+  if(!t || __C_hamt_decref(t))
+    return;
+
+  __C_hamt_release((__c_hamt_obj_t *)t->root, t->destructor);
+  C_free(t);
+}
+
+/*
+ */
+
+c_bool_t C_hamt_set_destructor(c_hamt_t *t, void (*destructor)(void *))
+{
+  /* all versions that share nodes must agree on the destructor */
+
+  if(!t || t->size)
+    return(FALSE);
+
+  t->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hamt_set_hashfunc(c_hamt_t *t, c_hashfunc_t func)
+{
+  if(!t || !func || t->size)
+    return(FALSE);
+
+  t->hashfunc = func;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hamt_set_seed(c_hamt_t *t, uint64_t seed)
+{
+  if(!t || t->size)
+    return(FALSE);
+
+  t->seed = seed;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_hamt_t *C_hamt_store(c_hamt_t *t, const char *key, const void *data)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_hamt_store_len(t, key, strlen(key), data));
+}
+
+/*
+ */
+
+c_hamt_t *C_hamt_store_len(c_hamt_t *t, const void *key, size_t len,
+                           const void *data)
+{
+  __c_hamt_leaf_t *leaf;
+  __c_hamt_obj_t *root;
+  c_bool_t replaced = FALSE;
+  uint64_t hash;
+
+  if(!t || !key || !len || !data)
+    return(NULL);
+
+  hash = t->hashfunc(key, len, t->seed);
+
+  /* storing the same data again must not produce a second leaf that
+     refers to it, or the data would be destroyed with the first one;
+     this catches only the same key in the same version, so storing the
+     data under another key, or again after it was deleted while an
+     older version still holds it, is not allowed when a destructor is
+     set (see the manual) */
+
+  if(C_hamt_restore_len(t, key, len) == data)
+    return(C_hamt_retain(t));
+
+  leaf = __C_hamt_leaf_create(key, len, hash, data);
+  root = __C_hamt_insert((__c_hamt_obj_t *)t->root, 0, leaf, &replaced);
+
+  return(__C_hamt_version(t, root, t->size + (replaced ? 0 : 1)));
+}
+
+/*
+ */
+
+void *C_hamt_restore(c_hamt_t *t, const char *key)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_hamt_restore_len(t, key, strlen(key)));
+}
+
+/*
+ */
+
+void *C_hamt_restore_len(c_hamt_t *t, const void *key, size_t len)
+{
+  __c_hamt_obj_t *obj;
+  __c_hamt_node_t *node;
+  __c_hamt_leaf_t *leaf;
+  uint64_t hash;
+  uint32_t bit;
+  uint_t i, shift = 0;
+
+  if(!t || !key || !len)
+    return(NULL);
+
+  hash = t->hashfunc(key, len, t->seed);
+
+  for(obj = (__c_hamt_obj_t *)t->root; obj; shift += __C_HAMT_BITS)
+  {
+    node = (__c_hamt_node_t *)obj;
+
+    switch(obj->kind)
+    {
+      case __C_HAMT_LEAF:
+        leaf = (__c_hamt_leaf_t *)obj;
+        if((leaf->hash == hash) && (leaf->keylen == len)
+           && !memcmp(leaf->key, key, len))
+          return(leaf->data);
+
+        return(NULL);
+
+      case __C_HAMT_COLLISION:
+        if(node->hash != hash)
+          return(NULL);
+
+        for(i = 0; i < node->count; ++i)
+        {
+          leaf = (__c_hamt_leaf_t *)node->child[i];
+          if((leaf->keylen == len) && !memcmp(leaf->key, key, len))
+            return(leaf->data);
+        }
+
+        return(NULL);
+
+      default:
+        bit = (uint32_t)1 << __C_hamt_index(hash, shift);
+        if(!(node->bitmap & bit))
+          return(NULL);
+
+        obj = node->child[__C_hamt_popcount(node->bitmap & (bit - 1))];
+        break;
+    }
+  }
+
+  return(NULL);
+}
+
+/*
+ */
+
+c_hamt_t *C_hamt_delete(c_hamt_t *t, const char *key)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_hamt_delete_len(t, key, strlen(key)));
+}
+
+/*
+ */
+
+c_hamt_t *C_hamt_delete_len(c_hamt_t *t, const void *key, size_t len)
+{
+  __c_hamt_obj_t *root;
+  c_bool_t found;
+
+  if(!t || !key || !len)
+    return(NULL);
+
+  root = __C_hamt_remove((__c_hamt_obj_t *)t->root, 0, key, len,
+                         t->hashfunc(key, len, t->seed), &found);
+
+  if(!found)
+    return(C_hamt_retain(t));
+
+  return(__C_hamt_version(t, root, t->size - 1));
+}
+
+/*
+ */
+
+c_bool_t C_hamt_iterate(c_hamt_t *t,
+                        c_bool_t (*consumer)(const char *key, size_t len,
+                                             void *data, void *hook),
+                        void *hook)
+{
+  if(!t || !consumer)
+    return(FALSE);
+
+  if(!t->root)
+    return(TRUE);
+
+  return(__C_hamt_iterate((__c_hamt_obj_t *)t->root, consumer, hook));
+}
+
+/*
+ */
+
+c_hamtref_t *C_hamtref_create(c_hamt_t *t)
+{
+  c_hamtref_t *r;
+
+  if(!t)
+    return(NULL);
+
+  r = C_new(c_hamtref_t);
+  r->current = t;
+
+#ifdef THREADED_LIBRARY
+  r->lock = C_new(pthread_mutex_t);
+  pthread_mutex_init((pthread_mutex_t *)r->lock, NULL);
+#endif /* THREADED_LIBRARY */
+
+  return(r);
+}
+
+/*
+ */
+
+void C_hamtref_destroy(c_hamtref_t *r)
+{
+  if(!r)
+    return;
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_destroy((pthread_mutex_t *)r->lock);
+  C_free(r->lock);
+#endif /* THREADED_LIBRARY */
+
+  C_hamt_release(r->current);
+  C_free(r);
+}
+
+/*
+ */
+
+c_hamt_t *C_hamtref_acquire(c_hamtref_t *r)
+{
+#ifdef THREADED_LIBRARY
+  uint_t epoch, *readers;
+  c_hamt_t *t;
+#endif /* THREADED_LIBRARY */
+
+  if(!r)
+    return(NULL);
+
+#ifdef THREADED_LIBRARY
+
+  /* Announce this reader in the counter for the current epoch before
+     loading the version pointer. A writer that replaces the version
+     advances the epoch and then waits for that counter to drain before
+     dropping its reference to the old version, so the old version
+     cannot be freed between our load and our increment of its reference
+     count. If the epoch moves under us, announce again in the new one. */
+
+  for(;;)
+  {
+    epoch = __atomic_load_n(&(r->epoch), __ATOMIC_SEQ_CST);
+    readers = &(r->readers[epoch & 1]);
+
+    __atomic_add_fetch(readers, 1, __ATOMIC_SEQ_CST);
+
+    if(__atomic_load_n(&(r->epoch), __ATOMIC_SEQ_CST) == epoch)
+      break;
+
+    __atomic_sub_fetch(readers, 1, __ATOMIC_SEQ_CST);
+  }
+
+  t = C_hamt_retain(__atomic_load_n(&(r->current), __ATOMIC_SEQ_CST));
+  __atomic_sub_fetch(readers, 1, __ATOMIC_RELEASE);
+
+  return(t);
+
+#else
+
+  return(C_hamt_retain(r->current));
+
+#endif /* THREADED_LIBRARY */
+}
+
+/*
+ */
+
+c_bool_t C_hamtref_publish(c_hamtref_t *r, c_hamt_t *t)
+{
+  if(!r || !t)
+    return(FALSE);
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_lock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  __C_hamtref_swap(r, t);
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_unlock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hamtref_store(c_hamtref_t *r, const char *key, const void *data)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_hamtref_store_len(r, key, strlen(key), data));
+}
+
+/*
+ */
+
+c_bool_t C_hamtref_store_len(c_hamtref_t *r, const void *key, size_t len,
+                             const void *data)
+{
+  c_hamt_t *t;
+
+  if(!r)
+    return(FALSE);
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_lock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  /* writers are serialized, so the current version can be read directly */
+
+  if((t = C_hamt_store_len(r->current, key, len, data)) != NULL)
+  {
+    if(t == r->current)
+      C_hamt_release(t);
+    else
+      __C_hamtref_swap(r, t);
+  }
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_unlock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  return(t != NULL);
+}
+
+/*
+ */
+
+c_bool_t C_hamtref_delete(c_hamtref_t *r, const char *key)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_hamtref_delete_len(r, key, strlen(key)));
+}
+
+/*
+ */
+
+c_bool_t C_hamtref_delete_len(c_hamtref_t *r, const void *key, size_t len)
+{
+  c_hamt_t *t;
+  c_bool_t found = FALSE;
+
+  if(!r)
+    return(FALSE);
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_lock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  if((t = C_hamt_delete_len(r->current, key, len)) != NULL)
+  {
+    if(t == r->current)
+      C_hamt_release(t);
+    else
+    {
+      found = TRUE;
+      __C_hamtref_swap(r, t);
+    }
+  }
+
+#ifdef THREADED_LIBRARY
+  pthread_mutex_unlock((pthread_mutex_t *)r->lock);
+#endif /* THREADED_LIBRARY */
+
+  return(found);
+}
+
+/* end of source file */
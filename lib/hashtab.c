@@ -26,102 +26,1267 @@
 
 /* System headers */
 
+#include <fcntl.h>
 #include <string.h>
+#include <sys/time.h>
+#ifdef THREADED_LIBRARY
+#include <pthread.h>
+#endif /* THREADED_LIBRARY */
 
 /* Local headers */
 
+#include "hashcommon.h"
 #include "cbase/defs.h"
 #include "cbase/data.h"
 #include "cbase/system.h"
 #include "cbase/util.h"
 
+/* Macros */
+
+#define __C_HASHTABLE_MIN_SLOTS 8
+#define __C_HASHTABLE_MIN_LOAD_FACTOR 0.1
+#define __C_HASHTABLE_MAX_LOAD_FACTOR 0.95
+
+/* number of old slots migrated by each store, restore, or delete on a
+   table that is being rehashed incrementally */
+
+#define __C_HASHTABLE_REHASH_STEP 16
+
+#define __C_HASHTABLE_GOLDEN 0x9E3779B97F4A7C15ULL
+
+/* Maps a hash value onto a slot index, using the high bits of the product
+   of the hash and the golden ratio ("Fibonacci hashing"). This compensates
+   for hash functions with poorly-distributed low bits. */
+
+#define __C_hashtable_home(S, V)                                \
+  ((uint_t)(((V) * __C_HASHTABLE_GOLDEN) >> (S)))
+
+#define __C_hashtable_mask(S)                   \
+  ((1U << (64 - (S))) - 1)
+
+#define __C_hashtable_dist(S, I, V)                                     \
+  (((I) - __C_hashtable_home((S), (V))) & __C_hashtable_mask(S))
+
+/* A slot in the old array of an incrementally rehashed table whose entry
+   has been deleted or migrated. Such a slot keeps its hash, so that the
+   probe-length invariant of the old array stays intact. */
+
+#define __C_HASHTABLE_TOMBSTONE ((char *)&__C_hashtable_tombstone)
+
+#define __C_hashtable_live(K)                                   \
+  ((K) && ((K) != __C_HASHTABLE_TOMBSTONE))
+
+#define __C_CHASHTABLE_MAX_SHARDS 4096
+
+/* Each shard of a concurrent table is padded out to two cache lines, so
+   that threads working on neighbouring shards do not contend for the
+   same line when taking their locks. */
+
+#define __C_CHASHTABLE_SHARD_SIZE 128
+
+/* The shard is chosen from the upper half of the hash; the shards
+   themselves place entries using the lower bits (chained tables) or the
+   Fibonacci product (open tables). */
+
+#define __C_chashtable_shard(H, V)                                      \
+  (&(((__c_chashtable_shard_t *)(H)->shards)                            \
+     [(uint_t)((V) >> 32) & ((H)->nshards - 1)]))
+
+#ifdef THREADED_LIBRARY
+
+#define __C_chashtable_rdlock(S) pthread_rwlock_rdlock(&((S)->s.lock))
+#define __C_chashtable_wrlock(S) pthread_rwlock_wrlock(&((S)->s.lock))
+#define __C_chashtable_unlock(S) pthread_rwlock_unlock(&((S)->s.lock))
+
+#else
+
+#define __C_chashtable_rdlock(S)
+#define __C_chashtable_wrlock(S)
+#define __C_chashtable_unlock(S)
+
+#endif /* THREADED_LIBRARY */
+
+/* Types */
+
+typedef union __c_chashtable_shard_t
+{
+  struct
+  {
+#ifdef THREADED_LIBRARY
+    pthread_rwlock_t lock;
+#endif /* THREADED_LIBRARY */
+    c_hashtable_t *table;
+  } s;
+  char pad[__C_CHASHTABLE_SHARD_SIZE];
+} __c_chashtable_shard_t;
+
 /* File scope variables */
 
-static uint_t (*__C_hashtable_hashfunc)(const char *s, uint_t modulo)
-  = C_string_hash;
+static char __C_hashtable_tombstone;
+
+static uint64_t __C_hashtable_secret = 0;
+
+#ifdef THREADED_LIBRARY
+
+static pthread_once_t __C_hashtable_once = PTHREAD_ONCE_INIT;
+
+#endif /* THREADED_LIBRARY */
+
+/* File scope functions */
+
+static void __C_hashtable_init_secret(void)
+{
+  struct timeval tv;
+  int fd;
+
+  if((fd = open("/dev/urandom", O_RDONLY)) >= 0)
+  {
+    if(read(fd, &__C_hashtable_secret, sizeof(__C_hashtable_secret))
+       != sizeof(__C_hashtable_secret))
+      __C_hashtable_secret = 0;
+
+    close(fd);
+  }
+
+  if(!__C_hashtable_secret)
+  {
+    gettimeofday(&tv, NULL);
+    __C_hashtable_secret = C_string_hash64_len(&tv, sizeof(tv),
+                                               (uint64_t)getpid());
+  }
+}
+
+/*
+ */
+
+uint64_t __C_hashtable_random_seed(void)
+{
+#ifdef THREADED_LIBRARY
+  pthread_once(&__C_hashtable_once, __C_hashtable_init_secret);
+#else
+  if(!__C_hashtable_secret)
+    __C_hashtable_init_secret();
+#endif /* THREADED_LIBRARY */
+
+  return(__C_hashtable_secret);
+}
+
+/*
+ */
+
+static char *__C_hashtable_key_copy(c_hashtable_t *h, const void *key,
+                                    size_t len)
+{
+  char *k;
+
+  if(h->flags & C_HASHTABLE_BORROWED_KEYS)
+    return((char *)key);
+
+  /* keep a terminating NUL, so that string keys remain strings */
+
+  k = C_malloc(len + 1, char);
+  memcpy(k, key, len);
+  k[len] = NUL;
+
+  return(k);
+}
+
+/*
+ */
+
+static void __C_hashtable_key_free(c_hashtable_t *h, char *key)
+{
+  if(!(h->flags & C_HASHTABLE_BORROWED_KEYS))
+    C_free(key);
+}
+
+/*
+ */
+
+static void __C_hashtable_open_alloc(c_hashtable_t *h, uint_t slots)
+{
+  uint_t bits;
+
+  for(bits = 0; (1U << bits) < slots; ++bits);
+
+  h->buckets = (1U << bits);
+  h->shift = 64 - bits;
+  h->threshold = (size_t)(h->buckets * h->load_factor);
+  h->slots = C_calloc(h->buckets, c_hashslot_t);
+}
+
+/*
+ */
+
+static c_hashslot_t *__C_hashtable_probe(c_hashslot_t *slots, uint_t shift,
+                                         uint64_t hash, const void *key,
+                                         size_t len)
+{
+  uint_t mask = __C_hashtable_mask(shift);
+  uint_t i, d;
+  c_hashslot_t *slot;
+
+  /* Robin Hood invariant: the probe can stop as soon as it reaches an
+     entry that is closer to its home slot than the key would be. */
+
+  for(i = __C_hashtable_home(shift, hash), d = 0;; i = (i + 1) & mask, ++d)
+  {
+    slot = &(slots[i]);
+
+    if(!slot->key || (__C_hashtable_dist(shift, i, slot->hash) < d))
+      return(NULL);
+
+    /* compare the stored hashes first; keys only on a full match */
+
+    if((slot->hash == hash) && (slot->keylen == len)
+       && (slot->key != __C_HASHTABLE_TOMBSTONE)
+       && !memcmp(slot->key, key, len))
+      return(slot);
+  }
+}
+
+/*
+ */
+
+static c_hashslot_t *__C_hashtable_open_find(c_hashtable_t *h,
+                                             const void *key, size_t len,
+                                             uint64_t hash, c_bool_t *old)
+{
+  c_hashslot_t *slot;
+
+  *old = FALSE;
+
+  if((slot = __C_hashtable_probe(h->slots, h->shift, hash, key, len)))
+    return(slot);
+
+  if(h->old_slots)
+  {
+    if((slot = __C_hashtable_probe(h->old_slots, h->old_shift, hash, key,
+                                   len)))
+      *old = TRUE;
+  }
+
+  return(slot);
+}
+
+/*
+ */
+
+static void __C_hashtable_open_insert(c_hashtable_t *h, c_hashslot_t entry)
+{
+  uint_t mask = h->buckets - 1;
+  uint_t i, d, sd;
+  c_hashslot_t *slot, tmp;
+
+  /* The entry is known not to be in the table. Walk forward from its home
+     slot, displacing any entry that is closer to its own home slot. */
+
+  for(i = __C_hashtable_home(h->shift, entry.hash), d = 0;;
+      i = (i + 1) & mask, ++d)
+  {
+    slot = &(h->slots[i]);
+
+    if(!slot->key)
+    {
+      *slot = entry;
+      return;
+    }
+
+    if((sd = __C_hashtable_dist(h->shift, i, slot->hash)) < d)
+    {
+      tmp = *slot;
+      *slot = entry;
+      entry = tmp;
+      d = sd;
+    }
+  }
+}
+
+/*
+ */
+
+static c_bool_t __C_hashtable_open_migrate(c_hashtable_t *h, uint_t steps)
+{
+  c_hashslot_t *slot;
+
+  /* Move up to 'steps' slots from the old array into the new one. A
+     migrated slot becomes a tombstone, since entries further along in
+     its probe sequence may still be waiting to be migrated. */
+
+  for(; steps && (h->rehash_pos < h->old_buckets); --steps, ++h->rehash_pos)
+  {
+    slot = &(h->old_slots[h->rehash_pos]);
+
+    if(__C_hashtable_live(slot->key))
+    {
+      __C_hashtable_open_insert(h, *slot);
+      slot->key = __C_HASHTABLE_TOMBSTONE;
+    }
+  }
+
+  if(h->rehash_pos < h->old_buckets)
+    return(TRUE);
+
+  C_free(h->old_slots);
+  h->old_slots = NULL;
+  h->old_buckets = 0;
+
+  return(FALSE);
+}
+
+/*
+ */
+
+static void __C_hashtable_open_grow(c_hashtable_t *h, uint_t slots)
+{
+  c_hashslot_t *old;
+  uint_t i, n;
+
+  /* an earlier incremental rehash must be finished first */
+
+  if(h->old_slots)
+    __C_hashtable_open_migrate(h, h->old_buckets);
+
+  old = h->slots;
+  n = h->buckets;
+
+  h->old_shift = h->shift;
+  __C_hashtable_open_alloc(h, slots);
+
+  if(h->flags & C_HASHTABLE_INCREMENTAL)
+  {
+    /* keep the old array around and migrate it a few slots at a time */
+
+    h->old_slots = old;
+    h->old_buckets = n;
+    h->rehash_pos = 0;
+    return;
+  }
+
+  /* the stored hashes are reused, so keys do not have to be rehashed */
+
+  for(i = 0; i < n; ++i)
+  {
+    if(old[i].key)
+      __C_hashtable_open_insert(h, old[i]);
+  }
+
+  C_free(old);
+}
+
+/*
+ */
+
+static c_hashslot_t *__C_hashtable_open_locate(c_hashtable_t *h,
+                                               const void *key, size_t len,
+                                               uint64_t hash,
+                                               c_bool_t *inserted)
+{
+  uint_t mask, i, d;
+  c_hashslot_t *slot, tmp;
+
+  if(h->old_slots)
+    __C_hashtable_open_migrate(h, __C_HASHTABLE_REHASH_STEP);
+
+  *inserted = FALSE;
+
+  if(h->old_slots)
+  {
+    if((slot = __C_hashtable_probe(h->old_slots, h->old_shift, hash, key,
+                                   len)))
+      return(slot);
+  }
+
+  /* grow before inserting, so that the slot returned below stays where it
+     is; but only if the key is not already present, since storing an
+     existing key adds nothing */
+
+  if(h->size >= h->threshold)
+  {
+    if((slot = __C_hashtable_probe(h->slots, h->shift, hash, key, len)))
+      return(slot);
+
+    __C_hashtable_open_grow(h, h->buckets * 2);
+  }
+
+  /* A single probe either finds the key, or finds the slot where it
+     belongs: an empty slot, or one whose occupant is closer to its home
+     slot than the key would be. */
+
+  mask = h->buckets - 1;
+
+  for(i = __C_hashtable_home(h->shift, hash), d = 0;; i = (i + 1) & mask, ++d)
+  {
+    slot = &(h->slots[i]);
+
+    if(!slot->key || (__C_hashtable_dist(h->shift, i, slot->hash) < d))
+      break;
+
+    if((slot->hash == hash) && (slot->keylen == len)
+       && !memcmp(slot->key, key, len))
+      return(slot);
+  }
+
+  tmp = *slot;
+
+  slot->hash = hash;
+  slot->key = __C_hashtable_key_copy(h, key, len);
+  slot->keylen = len;
+  slot->data = NULL;
+
+  /* the displaced entry moves further along the probe sequence */
+
+  if(tmp.key)
+    __C_hashtable_open_insert(h, tmp);
+
+  ++h->size;
+  *inserted = TRUE;
+
+  return(slot);
+}
+
+/*
+ */
+
+static c_bool_t __C_hashtable_open_store(c_hashtable_t *h, const void *key,
+                                         size_t len, uint64_t hash,
+                                         const void *data)
+{
+  c_hashslot_t *slot;
+  c_bool_t inserted;
+
+  slot = __C_hashtable_open_locate(h, key, len, hash, &inserted);
+
+  /* an open table holds at most one entry per key */
+
+  if(!inserted && h->destructor && slot->data && (slot->data != data))
+    h->destructor(slot->data);
+
+  slot->data = (void *)data;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void *__C_hashtable_open_restore(c_hashtable_t *h, const void *key,
+                                        size_t len, uint64_t hash)
+{
+  c_hashslot_t *slot;
+  c_bool_t old;
+
+  if(h->old_slots)
+    __C_hashtable_open_migrate(h, __C_HASHTABLE_REHASH_STEP);
+
+  slot = __C_hashtable_open_find(h, key, len, hash, &old);
+
+  return(slot ? slot->data : NULL);
+}
+
+/*
+ */
+
+static c_bool_t __C_hashtable_open_delete(c_hashtable_t *h, const void *key,
+                                          size_t len, uint64_t hash)
+{
+  c_hashslot_t *slot, *next;
+  uint_t mask = h->buckets - 1;
+  uint_t i;
+  c_bool_t old;
+
+  if(h->old_slots)
+    __C_hashtable_open_migrate(h, __C_HASHTABLE_REHASH_STEP);
+
+  if(!(slot = __C_hashtable_open_find(h, key, len, hash, &old)))
+    return(FALSE);
+
+  __C_hashtable_key_free(h, slot->key);
+
+  if(h->destructor && slot->data)
+    h->destructor(slot->data);
+
+  --h->size;
+
+  if(old)
+  {
+    /* nothing is ever shifted within the old array */
+
+    slot->key = __C_HASHTABLE_TOMBSTONE;
+    return(TRUE);
+  }
+
+  /* Backward-shift deletion: pull each following entry that is not in its
+     home slot back by one, so that no tombstones are needed. */
+
+  for(i = (uint_t)(slot - h->slots);; i = (i + 1) & mask)
+  {
+    next = &(h->slots[(i + 1) & mask]);
+
+    if(!next->key || !__C_hashtable_dist(h->shift, (i + 1) & mask, next->hash))
+      break;
+
+    h->slots[i] = *next;
+  }
+
+  C_zero(&(h->slots[i]), c_hashslot_t);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void __C_hashtable_open_free(c_hashtable_t *h, c_hashslot_t *slots,
+                                    uint_t n)
+{
+  c_hashslot_t *slot;
+
+  for(slot = slots; n--; ++slot)
+  {
+    if(__C_hashtable_live(slot->key))
+    {
+      __C_hashtable_key_free(h, slot->key);
+
+      if(h->destructor && slot->data)
+        h->destructor(slot->data);
+    }
+  }
+
+  C_free(slots);
+}
+
+/*
+ */
+
+static c_tag_t *__C_hashtable_new_tag(c_hashtable_t *h)
+{
+  if(h->slab)
+    return((c_tag_t *)C_slab_alloc(h->slab));
+
+  return(C_new(c_tag_t));
+}
+
+/*
+ */
+
+static void __C_hashtable_free_tag(c_hashtable_t *h, c_tag_t *tag)
+{
+  if(h->slab)
+    C_slab_free(h->slab, tag);
+  else
+    C_free(tag);
+}
+
+/*
+ */
+
+static c_linklist_t *__C_hashtable_new_chain(c_hashtable_t *h)
+{
+  c_linklist_t *l = C_linklist_create();
+
+  C_linklist_set_slab(l, h->slab);
+
+  return(l);
+}
+
+/*
+ */
+
+static c_bool_t __C_hashtable_store_hashed(c_hashtable_t *h, const void *key,
+                                           size_t len, uint64_t hash,
+                                           const void *data)
+{
+  c_tag_t *tag;
+  c_linklist_t **l;
+
+  if(h->flags & C_HASHTABLE_OPEN)
+    return(__C_hashtable_open_store(h, key, len, hash, data));
+
+  tag = __C_hashtable_new_tag(h);
+  tag->key = __C_hashtable_key_copy(h, key, len);
+  tag->data = (char *)data;
+  tag->keylen = len;
+  tag->hash = hash;
+
+  l = &(h->table[hash % h->buckets]);
+
+  if(!(*l))
+    *l = __C_hashtable_new_chain(h);
+
+  C_linklist_prepend(*l, (void *)tag);
+  ++h->size;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void *__C_hashtable_restore_hashed(c_hashtable_t *h, const void *key,
+                                          size_t len, uint64_t hash)
+{
+  c_tag_t *tag;
+  c_linklist_t *l;
+  c_link_t *link;
+
+  if(h->flags & C_HASHTABLE_OPEN)
+    return(__C_hashtable_open_restore(h, key, len, hash));
+
+  /* walk the chain directly; a lookup must not move the list's cursor */
+
+  if((l = h->table[hash % h->buckets]))
+  {
+    for(link = C_linklist_head(l); link; link = C_link_next(link))
+    {
+      tag = (c_tag_t *)C_link_data(link);
+      if((tag->hash == hash) && (tag->keylen == len)
+         && !memcmp(tag->key, key, len))
+        return(tag->data);
+    }
+  }
+
+  return(NULL);
+}
+
+/*
+ */
+
+static c_bool_t __C_hashtable_delete_hashed(c_hashtable_t *h, const void *key,
+                                            size_t len, uint64_t hash)
+{
+  c_tag_t *tag;
+  c_linklist_t *l;
+  c_link_t *p;
+
+  if(h->flags & C_HASHTABLE_OPEN)
+    return(__C_hashtable_open_delete(h, key, len, hash));
+
+  if((l = h->table[hash % h->buckets]))
+  {
+    for(C_linklist_move_head_r(l, &p); p; C_linklist_move_next_r(l, &p))
+    {
+      tag = (c_tag_t *)C_link_data(p);
+      if((tag->hash == hash) && (tag->keylen == len)
+         && !memcmp(tag->key, key, len))
+      {
+        C_linklist_delete_r(l, &p);
+        --h->size;
+
+        __C_hashtable_key_free(h, tag->key);
+
+        if(h->destructor && tag->data)
+          h->destructor(tag->data);
+
+        __C_hashtable_free_tag(h, tag);
+
+        return(TRUE);
+      }
+    }
+  }
+
+  return(FALSE);
+}
+
+/* Functions */
+
+c_bool_t C_hashtable_set_hashfunc(c_hashtable_t *h, c_hashfunc_t func)
+{
+  /* existing entries were placed using the old function */
+
+  if(!h || !func || h->size)
+    return(FALSE);
+
+  h->hashfunc = func;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_set_seed(c_hashtable_t *h, uint64_t seed)
+{
+  if(!h || h->size)
+    return(FALSE);
+
+  h->seed = seed;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_set_slab(c_hashtable_t *h, c_slab_t *slab)
+{
+  uint_t i;
+
+  /* open tables keep their entries in the slot array itself */
+
+  if(!h || h->size || (h->flags & C_HASHTABLE_OPEN))
+    return(FALSE);
+
+  /* each object holds either a tag or the link that chains it */
+
+  if(slab && ((C_slab_objsize(slab) < sizeof(c_tag_t))
+              || (C_slab_objsize(slab) < sizeof(c_link_t))))
+    return(FALSE);
+
+  h->slab = slab;
+
+  for(i = 0; i < h->buckets; ++i)
+  {
+    if(h->table[i])
+      C_linklist_set_slab(h->table[i], slab);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_hashtable_t *C_hashtable_create(uint_t buckets)
+{
+  return(C_hashtable_create_flags(buckets, 0));
+}
+
+/*
+ */
+
+c_hashtable_t *C_hashtable_create_flags(uint_t buckets, int flags)
+{
+  c_hashtable_t *h;
+
+  if(!buckets)
+    return(NULL);
+
+  h = C_new(c_hashtable_t);
+  h->size = 0;
+  h->flags = flags;
+  h->load_factor = C_HASHTABLE_DEFAULT_LOAD_FACTOR;
+  h->hashfunc = C_string_hash64_len;
+
+  if(flags & C_HASHTABLE_RANDOM_SEED)
+    h->seed = __C_hashtable_random_seed();
+
+  if(flags & C_HASHTABLE_INCREMENTAL)
+    h->flags = (flags |= C_HASHTABLE_OPEN);
+
+  if(flags & C_HASHTABLE_OPEN)
+    __C_hashtable_open_alloc(h, C_max(buckets, __C_HASHTABLE_MIN_SLOTS));
+  else
+  {
+    h->buckets = buckets;
+    h->table = C_calloc(buckets, c_linklist_t *);
+  }
+
+  return(h);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_set_load_factor(c_hashtable_t *h, float factor)
+{
+  if(!h || !(h->flags & C_HASHTABLE_OPEN))
+    return(FALSE);
+
+  if((factor < __C_HASHTABLE_MIN_LOAD_FACTOR)
+     || (factor > __C_HASHTABLE_MAX_LOAD_FACTOR))
+    return(FALSE);
+
+  h->load_factor = factor;
+  h->threshold = (size_t)(h->buckets * factor);
+
+  while(h->size > h->threshold)
+    __C_hashtable_open_grow(h, h->buckets * 2);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_rehash_step(c_hashtable_t *h, uint_t steps)
+{
+  if(!h || !h->old_slots)
+    return(FALSE);
+
+  return(__C_hashtable_open_migrate(h, steps));
+}
+
+/*
+ */
+
+void C_hashtable_destroy(c_hashtable_t *h)
+{
+  uint_t i;
+  c_linklist_t **p;
+  c_tag_t *tag;
+
+  if(!h)
+    return;
+
+  if(h->flags & C_HASHTABLE_OPEN)
+  {
+    if(h->old_slots)
+      __C_hashtable_open_free(h, h->old_slots, h->old_buckets);
+
+    __C_hashtable_open_free(h, h->slots, h->buckets);
+    C_free(h);
+    return;
+  }
+
+  /* delete each linked list */
+
+  for(i = h->buckets, p = h->table; i--; ++p)
+  {
+    if(*p)
+    {
+      /* delete each tag (& its key) in the linked list */
+
+      for(C_linklist_move_head(*p);
+          (tag = (c_tag_t *)C_linklist_restore(*p)) != NULL;
+          C_linklist_move_next(*p))
+      {
+        __C_hashtable_key_free(h, tag->key);
+
+        if(h->destructor && tag->data)
+          h->destructor(tag->data);
+
+        __C_hashtable_free_tag(h, tag);
+      }
+
+      C_linklist_destroy(*p);
+    }
+  }
+
+  /* delete the backbone and the container structure */
+
+  C_free(h->table);
+  C_free(h);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_set_destructor(c_hashtable_t *h,
+                                    void (*destructor)(void *data))
+{
+  if(!h)
+    return(FALSE);
+
+  h->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_store(c_hashtable_t *h, const char *key, const void *data)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_hashtable_store_len(h, key, strlen(key), data));
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_store_len(c_hashtable_t *h, const void *key, size_t len,
+                               const void *data)
+{
+  if(!h || !key || !len || !data)
+    return(FALSE);
+
+  return(__C_hashtable_store_hashed(h, key, len,
+                                    h->hashfunc(key, len, h->seed), data));
+}
+
+/*
+ */
+
+void *C_hashtable_restore(c_hashtable_t *h, const char *key)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_hashtable_restore_len(h, key, strlen(key)));
+}
+
+/*
+ */
+
+void *C_hashtable_restore_len(c_hashtable_t *h, const void *key, size_t len)
+{
+  if(!h || !key || !len)
+    return(NULL);
+
+  return(__C_hashtable_restore_hashed(h, key, len,
+                                      h->hashfunc(key, len, h->seed)));
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_delete(c_hashtable_t *h, const char *key)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_hashtable_delete_len(h, key, strlen(key)));
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_delete_len(c_hashtable_t *h, const void *key, size_t len)
+{
+  if(!h || !key || !len)
+    return(FALSE);
+
+  return(__C_hashtable_delete_hashed(h, key, len,
+                                     h->hashfunc(key, len, h->seed)));
+}
+
+/*
+ */
 
-/* Functions */
+void **C_hashtable_find_or_insert(c_hashtable_t *h, const char *key,
+                                  c_bool_t *inserted)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_hashtable_find_or_insert_len(h, key, strlen(key), inserted));
+}
+
+/*
+ */
 
-c_bool_t C_hashtable_set_hashfunc(uint_t (*func)(const char *s, uint_t modulo))
+void **C_hashtable_find_or_insert_len(c_hashtable_t *h, const void *key,
+                                      size_t len, c_bool_t *inserted)
 {
-  c_bool_t r = FALSE;
+  c_tag_t *tag;
+  c_linklist_t **l;
+  c_link_t *link;
+  c_hashslot_t *slot;
+  uint64_t hash;
+  c_bool_t ins;
 
-  if(func)
-    __C_hashtable_hashfunc = func, r = TRUE;
+  if(!h || !key || !len)
+    return(NULL);
 
-  return(r);
+  if(!inserted)
+    inserted = &ins;
+
+  hash = h->hashfunc(key, len, h->seed);
+
+  if(h->flags & C_HASHTABLE_OPEN)
+  {
+    slot = __C_hashtable_open_locate(h, key, len, hash, inserted);
+    return(&(slot->data));
+  }
+
+  l = &(h->table[hash % h->buckets]);
+
+  if(*l)
+  {
+    for(link = C_linklist_head(*l); link; link = C_link_next(link))
+    {
+      tag = (c_tag_t *)C_link_data(link);
+      if((tag->hash == hash) && (tag->keylen == len)
+         && !memcmp(tag->key, key, len))
+      {
+        *inserted = FALSE;
+        return(&(tag->data));
+      }
+    }
+  }
+  else
+    *l = __C_hashtable_new_chain(h);
+
+  tag = __C_hashtable_new_tag(h);
+  tag->key = __C_hashtable_key_copy(h, key, len);
+  tag->keylen = len;
+  tag->hash = hash;
+
+  C_linklist_prepend(*l, (void *)tag);
+  ++h->size;
+  *inserted = TRUE;
+
+  return(&(tag->data));
 }
 
 /*
  */
 
-c_hashtable_t *C_hashtable_create(uint_t buckets)
+void **C_hashtable_upsert(c_hashtable_t *h, const char *key, const void *data)
 {
-  c_hashtable_t *h;
+  if(!key)
+    return(NULL);
 
-  if(!buckets)
+  return(C_hashtable_upsert_len(h, key, strlen(key), data));
+}
+
+/*
+ */
+
+void **C_hashtable_upsert_len(c_hashtable_t *h, const void *key, size_t len,
+                              const void *data)
+{
+  void **slot;
+  c_bool_t inserted;
+
+  if(!data)
     return(NULL);
 
-  h = C_new(c_hashtable_t);
-  h->buckets = buckets;
-  h->size = 0;
-  h->table = C_calloc(buckets, c_linklist_t *);
+  if(!(slot = C_hashtable_find_or_insert_len(h, key, len, &inserted)))
+    return(NULL);
 
-  return(h);
+  if(!inserted && h->destructor && *slot && (*slot != data))
+    h->destructor(*slot);
+
+  *slot = (void *)data;
+
+  return(slot);
 }
 
 /*
  */
 
-void C_hashtable_destroy(c_hashtable_t *h)
+char **C_hashtable_keys(c_hashtable_t *h, size_t *len)
 {
-  uint_t i;
-  c_linklist_t **p;
-  c_tag_t *tag;
+  c_hashtable_iter_t iter;
+  c_vector_t *vec;
+  const char *key;
 
   if(!h)
-    return;
+    return(NULL);
 
-  /* delete each linked list */
+  vec = C_vector_start(C_max(h->size, 1));
 
-  for(i = h->buckets, p = h->table; i--; ++p)
+  C_hashtable_iter_init(h, &iter);
+  while(C_hashtable_iter_next(&iter, &key, NULL, NULL))
+    C_vector_store(vec, C_string_dup(key));
+
+  return(C_vector_end(vec, len));
+}
+
+/*
+ */
+
+void C_hashtable_iter_init(c_hashtable_t *h, c_hashtable_iter_t *iter)
+{
+  C_zero(iter, c_hashtable_iter_t);
+  iter->table = h;
+  iter->old = (h && h->old_slots) ? TRUE : FALSE;
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_iter_next(c_hashtable_iter_t *iter, const char **key,
+                               size_t *len, void **data)
+{
+  c_hashtable_t *h = iter->table;
+  c_hashslot_t *slot;
+  c_tag_t *tag;
+
+  if(!h)
+    return(FALSE);
+
+  if(h->flags & C_HASHTABLE_OPEN)
   {
-    if(*p)
+    /* the old array, if a resize is in progress, then the current one */
+
+    for(;;)
     {
-      /* delete each tag (& its key) in the linked list */
+      c_hashslot_t *slots = iter->old ? h->old_slots : h->slots;
+      uint_t n = iter->old ? h->old_buckets : h->buckets;
 
-      for(C_linklist_move_head(*p);
-          (tag = (c_tag_t *)C_linklist_restore(*p)) != NULL;
-          C_linklist_move_next(*p))
+      for(; iter->pos < n; ++iter->pos)
       {
-        C_free(tag->key);
+        slot = &(slots[iter->pos]);
 
-        if(h->destructor)
-          h->destructor(tag->data);
+        if(__C_hashtable_live(slot->key) && slot->data)
+        {
+          ++iter->pos;
+
+          if(key)
+            *key = slot->key;
+          if(len)
+            *len = slot->keylen;
+          if(data)
+            *data = slot->data;
 
-        C_free(tag);
+          return(TRUE);
+        }
       }
 
-      C_linklist_destroy(*p);
+      if(!iter->old)
+        return(FALSE);
+
+      iter->old = FALSE;
+      iter->pos = 0;
     }
   }
 
-  /* delete the backbone and the container structure */
+  /* walk the chains directly, rather than through the lists' cursors */
 
-  C_free(h->table);
+  for(;;)
+  {
+    while(!iter->link)
+    {
+      if(iter->pos >= h->buckets)
+        return(FALSE);
+
+      if(h->table[iter->pos])
+        iter->link = C_linklist_head(h->table[iter->pos]);
+
+      ++iter->pos;
+    }
+
+    tag = (c_tag_t *)C_link_data(iter->link);
+    iter->link = C_link_next(iter->link);
+
+    if(tag->data)
+    {
+      if(key)
+        *key = tag->key;
+      if(len)
+        *len = tag->keylen;
+      if(data)
+        *data = tag->data;
+
+      return(TRUE);
+    }
+  }
+}
+
+/*
+ */
+
+c_bool_t C_hashtable_iterate(c_hashtable_t *h,
+                             c_bool_t (*consumer)(const char *key, size_t len,
+                                                  void *data, void *hook),
+                             void *hook)
+{
+  c_hashtable_iter_t iter;
+  const char *key;
+  size_t len;
+  void *data;
+
+  if(!h || !consumer)
+    return(FALSE);
+
+  C_hashtable_iter_init(h, &iter);
+  while(C_hashtable_iter_next(&iter, &key, &len, &data))
+  {
+    if(!consumer(key, len, data, hook))
+      return(FALSE);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_chashtable_t *C_chashtable_create(uint_t shards, uint_t buckets, int flags)
+{
+  c_chashtable_t *h;
+  __c_chashtable_shard_t *shard;
+  uint_t i, n;
+
+  if(!buckets || (shards > __C_CHASHTABLE_MAX_SHARDS))
+    return(NULL);
+
+  if(!shards)
+    shards = C_CHASHTABLE_DEFAULT_SHARDS;
+
+  for(n = 1; n < shards; n <<= 1)
+    ;
+
+  /* an incrementally rehashed table moves entries during lookups, which
+     would force readers to take the write lock; the shards are small
+     enough that an ordinary resize is cheap */
+
+  if(flags & C_HASHTABLE_INCREMENTAL)
+    flags = (flags & ~C_HASHTABLE_INCREMENTAL) | C_HASHTABLE_OPEN;
+
+  h = C_new(c_chashtable_t);
+  h->nshards = n;
+  h->shards = C_calloc(n, __c_chashtable_shard_t);
+  h->hashfunc = C_string_hash64_len;
+
+  if(flags & C_HASHTABLE_RANDOM_SEED)
+    h->seed = __C_hashtable_random_seed();
+
+  flags &= ~C_HASHTABLE_RANDOM_SEED;
+
+  for(i = 0, shard = (__c_chashtable_shard_t *)h->shards; i < n;
+      ++i, ++shard)
+  {
+#ifdef THREADED_LIBRARY
+    pthread_rwlock_init(&(shard->s.lock), NULL);
+#endif /* THREADED_LIBRARY */
+
+    shard->s.table = C_hashtable_create_flags(buckets, flags);
+    shard->s.table->seed = h->seed;
+  }
+
+  return(h);
+}
+
+/*
+ */
+
+void C_chashtable_destroy(c_chashtable_t *h)
+{
+  __c_chashtable_shard_t *shard;
+  uint_t i;
+
+  if(!h)
+    return;
+
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards; i--;
+      ++shard)
+  {
+    C_hashtable_destroy(shard->s.table);
+
+#ifdef THREADED_LIBRARY
+    pthread_rwlock_destroy(&(shard->s.lock));
+#endif /* THREADED_LIBRARY */
+  }
+
+  C_free(h->shards);
   C_free(h);
 }
 
 /*
  */
 
-c_bool_t C_hashtable_set_destructor(c_hashtable_t *h,
-                                    void (*destructor)(void *data))
+c_bool_t C_chashtable_set_destructor(c_chashtable_t *h,
+                                     void (*destructor)(void *))
 {
+  __c_chashtable_shard_t *shard;
+  uint_t i;
+
   if(!h)
     return(FALSE);
 
-  h->destructor = destructor;
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards; i--;
+      ++shard)
+  {
+    __C_chashtable_wrlock(shard);
+    shard->s.table->destructor = destructor;
+    __C_chashtable_unlock(shard);
+  }
 
   return(TRUE);
 }
@@ -129,27 +1294,39 @@ c_bool_t C_hashtable_set_destructor(c_hashtable_t *h,
 /*
  */
 
-c_bool_t C_hashtable_store(c_hashtable_t *h, const char *key, const void *data)
+c_bool_t C_chashtable_set_hashfunc(c_chashtable_t *h, c_hashfunc_t func)
 {
-  c_tag_t *tag;
-  c_linklist_t **l;
+  __c_chashtable_shard_t *shard;
+  uint_t i;
 
-  if(!h || !key || !data)
-    return(FALSE);
-  if(!*key)
+  if(!h || !func || C_chashtable_size(h))
     return(FALSE);
 
-  tag = C_new(c_tag_t);
-  tag->key = C_string_dup(key);
-  tag->data = (char *)data;
+  h->hashfunc = func;
 
-  l = &(h->table[__C_hashtable_hashfunc(key, h->buckets)]);
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards; i--;
+      ++shard)
+    shard->s.table->hashfunc = func;
 
-  if(!(*l))
-    *l = C_linklist_create();
+  return(TRUE);
+}
 
-  C_linklist_prepend(*l, (void *)tag);
-  ++h->size;
+/*
+ */
+
+c_bool_t C_chashtable_set_seed(c_chashtable_t *h, uint64_t seed)
+{
+  __c_chashtable_shard_t *shard;
+  uint_t i;
+
+  if(!h || C_chashtable_size(h))
+    return(FALSE);
+
+  h->seed = seed;
+
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards; i--;
+      ++shard)
+    shard->s.table->seed = seed;
 
   return(TRUE);
 }
@@ -157,96 +1334,158 @@ c_bool_t C_hashtable_store(c_hashtable_t *h, const char *key, const void *data)
 /*
  */
 
-void *C_hashtable_restore(c_hashtable_t *h, const char *key)
+c_bool_t C_chashtable_store(c_chashtable_t *h, const char *key,
+                            const void *data)
 {
-  c_tag_t *tag;
-  c_linklist_t *l;
-
-  if(!h || !key)
+  if(!key)
     return(FALSE);
-  if(! *key)
+
+  return(C_chashtable_store_len(h, key, strlen(key), data));
+}
+
+/*
+ */
+
+c_bool_t C_chashtable_store_len(c_chashtable_t *h, const void *key,
+                                size_t len, const void *data)
+{
+  __c_chashtable_shard_t *shard;
+  uint64_t hash;
+  c_bool_t r;
+
+  if(!h || !key || !len || !data)
     return(FALSE);
 
-  if((l = h->table[__C_hashtable_hashfunc(key, h->buckets)]))
-  {
-    for(C_linklist_move_head(l); !C_linklist_isend(l);
-        C_linklist_move_next(l))
-    {
-      tag = (c_tag_t *)C_linklist_restore(l);
-      if(!strcmp(tag->key, key))
-        return(tag->data);
-    }
-  }
+  /* hash outside of the lock, and only once */
 
-  return(NULL);
+  hash = h->hashfunc(key, len, h->seed);
+  shard = __C_chashtable_shard(h, hash);
+
+  __C_chashtable_wrlock(shard);
+  r = __C_hashtable_store_hashed(shard->s.table, key, len, hash, data);
+  __C_chashtable_unlock(shard);
+
+  return(r);
 }
 
 /*
  */
 
-c_bool_t C_hashtable_delete(c_hashtable_t *h, const char *key)
+void *C_chashtable_restore(c_chashtable_t *h, const char *key)
 {
-  c_tag_t *tag;
-  c_linklist_t *l;
+  if(!key)
+    return(NULL);
+
+  return(C_chashtable_restore_len(h, key, strlen(key)));
+}
+
+/*
+ */
+
+void *C_chashtable_restore_len(c_chashtable_t *h, const void *key,
+                               size_t len)
+{
+  __c_chashtable_shard_t *shard;
+  uint64_t hash;
+  void *r;
+
+  if(!h || !key || !len)
+    return(NULL);
 
-  if(! *key)
+  hash = h->hashfunc(key, len, h->seed);
+  shard = __C_chashtable_shard(h, hash);
+
+  __C_chashtable_rdlock(shard);
+  r = __C_hashtable_restore_hashed(shard->s.table, key, len, hash);
+  __C_chashtable_unlock(shard);
+
+  return(r);
+}
+
+/*
+ */
+
+c_bool_t C_chashtable_delete(c_chashtable_t *h, const char *key)
+{
+  if(!key)
     return(FALSE);
 
-  if((l = h->table[__C_hashtable_hashfunc(key, h->buckets)]))
-  {
-    for(C_linklist_move_head(l); !C_linklist_isend(l);
-        C_linklist_move_next(l))
-    {
-      tag = (c_tag_t *)C_linklist_restore(l);
-      if(!strcmp(tag->key, key))
-      {
-        C_linklist_delete(l);
-        --h->size;
+  return(C_chashtable_delete_len(h, key, strlen(key)));
+}
+
+/*
+ */
 
-        C_free(tag->key);
+c_bool_t C_chashtable_delete_len(c_chashtable_t *h, const void *key,
+                                 size_t len)
+{
+  __c_chashtable_shard_t *shard;
+  uint64_t hash;
+  c_bool_t r;
 
-        if(h->destructor)
-          h->destructor(tag->data);
+  if(!h || !key || !len)
+    return(FALSE);
 
-        C_free(tag);
+  hash = h->hashfunc(key, len, h->seed);
+  shard = __C_chashtable_shard(h, hash);
 
-        return(TRUE);
-      }
-    }
-  }
+  __C_chashtable_wrlock(shard);
+  r = __C_hashtable_delete_hashed(shard->s.table, key, len, hash);
+  __C_chashtable_unlock(shard);
 
-  return(FALSE);
+  return(r);
 }
 
 /*
  */
 
-char **C_hashtable_keys(c_hashtable_t *h, size_t *len)
+size_t C_chashtable_size(c_chashtable_t *h)
 {
-  c_vector_t *vec;
-  c_linklist_t **p;
-  c_tag_t *t;
-  char **v;
+  __c_chashtable_shard_t *shard;
+  size_t size = 0;
   uint_t i;
 
   if(!h)
-    return(NULL);
+    return(0);
 
-  vec = C_vector_start(h->buckets);
-
-  for(i = h->buckets, p = h->table; i--; ++p)
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards; i--;
+      ++shard)
   {
-    for(C_linklist_move_head(*p);
-        (t = (c_tag_t *)C_linklist_restore(*p)) != NULL;
-        C_linklist_move_next(*p))
-    {
-      C_vector_store(vec, C_string_dup(t->key));
-    }
+    __C_chashtable_rdlock(shard);
+    size += shard->s.table->size;
+    __C_chashtable_unlock(shard);
   }
 
-  v = C_vector_end(vec, len);
+  return(size);
+}
+
+/*
+ */
+
+c_bool_t C_chashtable_iterate(c_chashtable_t *h,
+                              c_bool_t (*consumer)(const char *key,
+                                                   size_t len, void *data,
+                                                   void *hook),
+                              void *hook)
+{
+  __c_chashtable_shard_t *shard;
+  c_bool_t r = TRUE;
+  uint_t i;
+
+  if(!h || !consumer)
+    return(FALSE);
+
+  /* each shard is read-locked only while it is being visited */
 
-  return(v);
+  for(i = h->nshards, shard = (__c_chashtable_shard_t *)h->shards;
+      r && i--; ++shard)
+  {
+    __C_chashtable_rdlock(shard);
+    r = C_hashtable_iterate(shard->s.table, consumer, hook);
+    __C_chashtable_unlock(shard);
+  }
+
+  return(r);
 }
 
 /* end of source file */
@@ -0,0 +1,509 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <limits.h>
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_HEAP_MIN_CAPACITY 16
+
+#define __C_HEAP_ARITY 4
+
+#define __C_HEAP_LINE 64
+
+#define __C_HEAP_NONE UINT_MAX
+
+/* The heap proper is an array of keys, each with the handle of its item;
+   the items themselves, and the position of each in the heap, are kept
+   in a separate table indexed by handle, so that the heap can be
+   reordered without chasing pointers, and an item can be found by its
+   handle. The free handles are chained through their position fields.
+
+   The children of the node at position P are at positions 4P + 1
+   through 4P + 4. The nodes are stored 3 entries past the beginning of
+   a cache-aligned array, so that each group of siblings fills exactly
+   one cache line. */
+
+#define __C_HEAP_OFFSET (__C_HEAP_ARITY - 1)
+
+typedef struct __c_heap_entry_t
+{
+  int64_t key;
+  uint_t handle;
+} __c_heap_entry_t;
+
+typedef struct __c_heap_slot_t
+{
+  void *data;
+  uint_t pos;
+} __c_heap_slot_t;
+
+#define __C_heap_entry(H, P)                                    \
+  (((__c_heap_entry_t *)(H)->entries) + (P) + __C_HEAP_OFFSET)
+
+#define __C_heap_slot(H, N)                     \
+  (((__c_heap_slot_t *)(H)->slots) + (N))
+
+#define __C_heap_parent(P) (((P) - 1) / __C_HEAP_ARITY)
+
+#define __C_heap_child(P) (((P) * __C_HEAP_ARITY) + 1)
+
+/* File scope functions */
+
+static void *__C_heap_alloc_entries(uint_t capacity)
+{
+  return(C_mem_manage_aligned((capacity + __C_HEAP_OFFSET)
+                              * sizeof(__c_heap_entry_t),
+                              __C_HEAP_LINE, FALSE));
+}
+
+/*
+ */
+
+static void __C_heap_resize(c_heap_t *h, uint_t capacity)
+{
+  void *entries = h->entries;
+  uint_t i;
+
+  h->entries = __C_heap_alloc_entries(capacity);
+
+  if(entries)
+  {
+    memcpy(__C_heap_entry(h, 0),
+           ((__c_heap_entry_t *)entries) + __C_HEAP_OFFSET,
+           h->size * sizeof(__c_heap_entry_t));
+    C_free(entries);
+  }
+
+  h->slots = C_realloc(h->slots, capacity, __c_heap_slot_t);
+
+  /* the new handles are added to the free list in ascending order */
+
+  for(i = capacity; i > h->capacity; --i)
+  {
+    __C_heap_slot(h, i - 1)->data = NULL;
+    __C_heap_slot(h, i - 1)->pos = h->free_list;
+    h->free_list = i - 1;
+  }
+
+  h->capacity = capacity;
+}
+
+/*
+ */
+
+static c_bool_t __C_heap_grow(c_heap_t *h)
+{
+  if(h->capacity > (UINT_MAX >> 2))
+    return(FALSE);
+
+  __C_heap_resize(h, h->capacity * 2);
+
+  return(TRUE);
+}
+
+/* Move the entry at position pos up towards the root until its parent's
+   key is no greater than its own. */
+
+static void __C_heap_sift_up(c_heap_t *h, uint_t pos)
+{
+  __c_heap_entry_t e = *__C_heap_entry(h, pos), *p;
+  uint_t parent;
+
+  while(pos > 0)
+  {
+    parent = __C_heap_parent(pos);
+    p = __C_heap_entry(h, parent);
+
+    if(p->key <= e.key)
+      break;
+
+    *__C_heap_entry(h, pos) = *p;
+    __C_heap_slot(h, p->handle)->pos = pos;
+    pos = parent;
+  }
+
+  *__C_heap_entry(h, pos) = e;
+  __C_heap_slot(h, e.handle)->pos = pos;
+}
+
+/* Move the entry at position pos down towards the leaves until none of
+   its children's keys is less than its own. */
+
+static void __C_heap_sift_down(c_heap_t *h, uint_t pos)
+{
+  __c_heap_entry_t e = *__C_heap_entry(h, pos), *c, *min;
+  uint_t child, last, i;
+
+  for(;;)
+  {
+    child = __C_heap_child(pos);
+    if(child >= h->size)
+      break;
+
+    last = C_min(child + __C_HEAP_ARITY, h->size);
+    min = __C_heap_entry(h, child);
+
+    for(i = child + 1, c = min + 1; i < last; ++i, ++c)
+    {
+      if(c->key < min->key)
+        min = c;
+    }
+
+    if(min->key >= e.key)
+      break;
+
+    child = (uint_t)(min - __C_heap_entry(h, 0));
+    *__C_heap_entry(h, pos) = *min;
+    __C_heap_slot(h, min->handle)->pos = pos;
+    pos = child;
+  }
+
+  *__C_heap_entry(h, pos) = e;
+  __C_heap_slot(h, e.handle)->pos = pos;
+}
+
+/* Remove the entry at position pos, and return its item. */
+
+static void *__C_heap_remove_at(c_heap_t *h, uint_t pos, int64_t *key)
+{
+  __c_heap_entry_t *e = __C_heap_entry(h, pos);
+  __c_heap_slot_t *slot = __C_heap_slot(h, e->handle);
+  void *data = slot->data;
+  int64_t k = e->key;
+
+  if(key)
+    *key = k;
+
+  slot->data = NULL;
+  slot->pos = h->free_list;
+  h->free_list = e->handle;
+
+  /* the last entry takes the place of the removed one, and is then moved
+     up or down as its key requires */
+
+  if(pos < --h->size)
+  {
+    *e = *__C_heap_entry(h, h->size);
+
+    if(e->key < k)
+      __C_heap_sift_up(h, pos);
+    else
+      __C_heap_sift_down(h, pos);
+  }
+
+  return(data);
+}
+
+/*
+ */
+
+static __c_heap_slot_t *__C_heap_lookup(c_heap_t *h, c_heap_handle_t handle)
+{
+  __c_heap_slot_t *slot;
+
+  if(!h || (handle >= h->capacity))
+    return(NULL);
+
+  slot = __C_heap_slot(h, handle);
+
+  return(slot->data ? slot : NULL);
+}
+
+/* Functions */
+
+c_heap_t *C_heap_create(uint_t capacity)
+{
+  c_heap_t *h;
+  uint_t cap;
+
+  if(capacity > (UINT_MAX >> 2))
+    return(NULL);
+
+  cap = C_max(capacity, __C_HEAP_MIN_CAPACITY);
+
+  h = C_new(c_heap_t);
+  h->free_list = __C_HEAP_NONE;
+  __C_heap_resize(h, cap);
+
+  return(h);
+}
+
+/*
+ */
+
+c_heap_t *C_heap_create_from(const int64_t *keys, void * const *data,
+                             uint_t n)
+{
+  c_heap_t *h;
+  __c_heap_entry_t *e;
+  __c_heap_slot_t *slot;
+  uint_t i;
+
+  if(!keys || !data)
+    return(NULL);
+
+  for(i = 0; i < n; ++i)
+  {
+    if(! data[i])
+      return(NULL);
+  }
+
+  if(! (h = C_heap_create(n)))
+    return(NULL);
+
+  /* the items are given the handles 0 through n - 1, in order, which are
+     the first handles on the free list */
+
+  for(i = 0, e = __C_heap_entry(h, 0); i < n; ++i, ++e)
+  {
+    slot = __C_heap_slot(h, i);
+    h->free_list = slot->pos;
+
+    e->key = keys[i];
+    e->handle = i;
+    slot->data = data[i];
+    slot->pos = i;
+  }
+
+  h->size = n;
+
+  /* bottom-up heap construction, which takes linear time */
+
+  if(n > 1)
+  {
+    for(i = __C_heap_parent(n - 1) + 1; i > 0; --i)
+      __C_heap_sift_down(h, i - 1);
+  }
+
+  return(h);
+}
+
+/*
+ */
+
+void C_heap_destroy(c_heap_t *h)
+{
+  if(! h)
+    return;
+
+  C_heap_clear(h);
+
+  C_free(h->entries);
+  C_free(h->slots);
+  C_free(h);
+}
+
+/*
+ */
+
+c_bool_t C_heap_set_destructor(c_heap_t *h, void (*destructor)(void *))
+{
+  if(! h)
+    return(FALSE);
+
+  h->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_heap_push(c_heap_t *h, int64_t key, const void *data,
+                     c_heap_handle_t *handle)
+{
+  __c_heap_entry_t *e;
+  __c_heap_slot_t *slot;
+  uint_t n;
+
+  if(!h || !data)
+    return(FALSE);
+
+  if((h->size == h->capacity) && ! __C_heap_grow(h))
+    return(FALSE);
+
+  n = h->free_list;
+  slot = __C_heap_slot(h, n);
+  h->free_list = slot->pos;
+  slot->data = (void *)data;
+
+  e = __C_heap_entry(h, h->size);
+  e->key = key;
+  e->handle = n;
+
+  __C_heap_sift_up(h, h->size++);
+
+  if(handle)
+    *handle = n;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_heap_pop(c_heap_t *h, int64_t *key)
+{
+  if(!h || (h->size == 0))
+    return(NULL);
+
+  return(__C_heap_remove_at(h, 0, key));
+}
+
+/*
+ */
+
+void *C_heap_peek(c_heap_t *h, int64_t *key)
+{
+  __c_heap_entry_t *e;
+
+  if(!h || (h->size == 0))
+    return(NULL);
+
+  e = __C_heap_entry(h, 0);
+
+  if(key)
+    *key = e->key;
+
+  return(__C_heap_slot(h, e->handle)->data);
+}
+
+/*
+ */
+
+c_bool_t C_heap_decrease_key(c_heap_t *h, c_heap_handle_t handle,
+                             int64_t key)
+{
+  __c_heap_slot_t *slot;
+  __c_heap_entry_t *e;
+
+  if(! (slot = __C_heap_lookup(h, handle)))
+    return(FALSE);
+
+  e = __C_heap_entry(h, slot->pos);
+  if(key > e->key)
+    return(FALSE);
+
+  e->key = key;
+  __C_heap_sift_up(h, slot->pos);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_heap_update_key(c_heap_t *h, c_heap_handle_t handle, int64_t key)
+{
+  __c_heap_slot_t *slot;
+  __c_heap_entry_t *e;
+  int64_t old;
+
+  if(! (slot = __C_heap_lookup(h, handle)))
+    return(FALSE);
+
+  e = __C_heap_entry(h, slot->pos);
+  old = e->key;
+  e->key = key;
+
+  if(key < old)
+    __C_heap_sift_up(h, slot->pos);
+  else if(key > old)
+    __C_heap_sift_down(h, slot->pos);
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_heap_remove(c_heap_t *h, c_heap_handle_t handle, int64_t *key)
+{
+  __c_heap_slot_t *slot;
+
+  if(! (slot = __C_heap_lookup(h, handle)))
+    return(NULL);
+
+  return(__C_heap_remove_at(h, slot->pos, key));
+}
+
+/*
+ */
+
+void *C_heap_get(c_heap_t *h, c_heap_handle_t handle, int64_t *key)
+{
+  __c_heap_slot_t *slot;
+
+  if(! (slot = __C_heap_lookup(h, handle)))
+    return(NULL);
+
+  if(key)
+    *key = __C_heap_entry(h, slot->pos)->key;
+
+  return(slot->data);
+}
+
+/*
+ */
+
+void C_heap_clear(c_heap_t *h)
+{
+  __c_heap_slot_t *slot;
+  uint_t i;
+
+  if(! h)
+    return;
+
+  /* the handles are returned to the free list in ascending order */
+
+  h->free_list = __C_HEAP_NONE;
+
+  for(i = h->capacity; i > 0; --i)
+  {
+    slot = __C_heap_slot(h, i - 1);
+
+    if(slot->data && h->destructor)
+      h->destructor(slot->data);
+
+    slot->data = NULL;
+    slot->pos = h->free_list;
+    h->free_list = i - 1;
+  }
+
+  h->size = 0;
+}
+
+/* end of source file */
@@ -116,8 +116,9 @@ static c_bool_t __C_httpsrv_urldecode(char *text)
 static c_bool_t __C_httpsrv_parse_query(char *query, c_hashtable_t *params)
 {
   char *r, *key = query, *value = NULL;
-  c_bool_t inkey = TRUE;
+  c_bool_t inkey = TRUE, inserted;
   c_http_param_t *param;
+  void **slot;
 
   for(r = query; *r; ++r)
   {
@@ -137,12 +138,11 @@ static c_bool_t __C_httpsrv_parse_query(char *query, c_hashtable_t *params)
       if(! __C_httpsrv_urldecode(value))
         return(FALSE);
 
-      param = (c_http_param_t *)C_hashtable_restore(params, key);
-      if(! param)
-      {
-        param = C_new(c_http_param_t);
-        C_hashtable_store(params, key, param);
-      }
+      slot = C_hashtable_find_or_insert(params, key, &inserted);
+      if(inserted)
+        *slot = C_new(c_http_param_t);
+
+      param = (c_http_param_t *)*slot;
 
       if(! param->value && ! param->values)
         param->value = C_string_dup(value);
@@ -348,7 +348,10 @@ static void *__C_httpsrv_worker(void *arg)
 
   if(p)
   {
-    params = C_hashtable_create(10);
+    /* query parameter names come from the client, so use a seeded hash
+       to defeat hash flooding */
+
+    params = C_hashtable_create_flags(10, C_HASHTABLE_RANDOM_SEED);
     C_hashtable_set_destructor(params, __C_httpsrv_param_destructor);
 
     if(! __C_httpsrv_parse_query(p, params))
@@ -0,0 +1,356 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+#include "cbase/util.h"
+
+/* Macros */
+
+#define __C_IDMAP_MIN_SLOTS 8
+
+/* The table is grown when it becomes more than 3/4 full. */
+
+#define __C_idmap_threshold(N) (((N) >> 1) + ((N) >> 2))
+
+/* A slot whose key is 0 is empty; 0 is not a valid key. */
+
+#define __C_idmap_isempty(S) ((S)->key == 0)
+
+#define __C_idmap_home(M, K) ((uint_t)__C_idmap_mix(K) & (M)->mask)
+
+/* File scope functions */
+
+/* The finalizer of MurmurHash3: a cheap, invertible mixer which spreads
+   sequential or otherwise patterned IDs evenly over the low bits. */
+
+static uint64_t __C_idmap_mix(c_id_t key)
+{
+  uint64_t x = (uint64_t)key;
+
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+
+  return(x);
+}
+
+/*
+ */
+
+static void __C_idmap_alloc(c_idmap_t *m, uint_t slots)
+{
+  uint_t n;
+
+  for(n = __C_IDMAP_MIN_SLOTS; n < slots; n <<= 1)
+    ;
+
+  m->slots = C_calloc(n, c_datum_t);
+  m->mask = n - 1;
+  m->threshold = __C_idmap_threshold(n);
+}
+
+/* Returns the slot holding key, or the empty slot at which the probe for
+   it ended. */
+
+static c_datum_t *__C_idmap_probe(c_idmap_t *m, c_id_t key)
+{
+  c_datum_t *slot;
+  uint_t i;
+
+  for(i = __C_idmap_home(m, key);; i = (i + 1) & m->mask)
+  {
+    slot = &(m->slots[i]);
+    if((slot->key == key) || __C_idmap_isempty(slot))
+      return(slot);
+  }
+}
+
+/*
+ */
+
+static void __C_idmap_grow(c_idmap_t *m)
+{
+  c_datum_t *old = m->slots, *slot;
+  uint_t n = m->mask + 1, i;
+
+  __C_idmap_alloc(m, n * 2);
+
+  for(i = 0, slot = old; i < n; ++i, ++slot)
+  {
+    if(!__C_idmap_isempty(slot))
+      *(__C_idmap_probe(m, slot->key)) = *slot;
+  }
+
+  C_free(old);
+}
+
+/*
+ */
+
+static c_datum_t *__C_idmap_locate(c_idmap_t *m, c_id_t key,
+                                   c_bool_t *inserted)
+{
+  c_datum_t *slot;
+
+  slot = __C_idmap_probe(m, key);
+
+  if(!__C_idmap_isempty(slot))
+  {
+    *inserted = FALSE;
+    return(slot);
+  }
+
+  /* grow first if needed, so that the returned slot remains valid until
+     the next modification of the map */
+
+  if(m->size >= m->threshold)
+  {
+    __C_idmap_grow(m);
+    slot = __C_idmap_probe(m, key);
+  }
+
+  slot->key = key;
+  slot->value = NULL;
+  ++m->size;
+  *inserted = TRUE;
+
+  return(slot);
+}
+
+/* Functions */
+
+c_idmap_t *C_idmap_create(uint_t capacity)
+{
+  c_idmap_t *m;
+
+  m = C_new(c_idmap_t);
+  m->size = 0;
+  m->destructor = NULL;
+
+  /* size the table so that capacity entries fit without growing */
+
+  __C_idmap_alloc(m, capacity + (capacity / 3) + 1);
+
+  return(m);
+}
+
+/*
+ */
+
+void C_idmap_destroy(c_idmap_t *m)
+{
+  c_datum_t *slot;
+  uint_t i;
+
+  if(!m)
+    return;
+
+  if(m->destructor)
+  {
+    for(i = 0, slot = m->slots; i <= m->mask; ++i, ++slot)
+    {
+      if(!__C_idmap_isempty(slot) && slot->value)
+        m->destructor(slot->value);
+    }
+  }
+
+  C_free(m->slots);
+  C_free(m);
+}
+
+/*
+ */
+
+c_bool_t C_idmap_set_destructor(c_idmap_t *m, void (*destructor)(void *))
+{
+  if(!m)
+    return(FALSE);
+
+  m->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_idmap_store(c_idmap_t *m, c_id_t key, const void *data)
+{
+  c_datum_t *slot;
+  c_bool_t inserted;
+
+  if(!m || (key == 0LL) || !data)
+    return(FALSE);
+
+  slot = __C_idmap_locate(m, key, &inserted);
+
+  if(!inserted)
+    return(FALSE);
+
+  slot->value = (void *)data;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_idmap_restore(c_idmap_t *m, c_id_t key)
+{
+  c_datum_t *slot;
+  uint_t i;
+
+  if(!m || (key == 0LL))
+    return(NULL);
+
+  for(i = __C_idmap_home(m, key);; i = (i + 1) & m->mask)
+  {
+    slot = &(m->slots[i]);
+    if(slot->key == key)
+      return(slot->value);
+
+    if(__C_idmap_isempty(slot))
+      return(NULL);
+  }
+}
+
+/*
+ */
+
+void **C_idmap_find_or_insert(c_idmap_t *m, c_id_t key, c_bool_t *inserted)
+{
+  c_bool_t ins;
+
+  if(!m || (key == 0LL))
+    return(NULL);
+
+  return(&(__C_idmap_locate(m, key, inserted ? inserted : &ins)->value));
+}
+
+/*
+ */
+
+void **C_idmap_upsert(c_idmap_t *m, c_id_t key, const void *data)
+{
+  c_datum_t *slot;
+  c_bool_t inserted;
+
+  if(!m || (key == 0LL) || !data)
+    return(NULL);
+
+  slot = __C_idmap_locate(m, key, &inserted);
+
+  if(!inserted && m->destructor && slot->value && (slot->value != data))
+    m->destructor(slot->value);
+
+  slot->value = (void *)data;
+
+  return(&(slot->value));
+}
+
+/*
+ */
+
+c_bool_t C_idmap_delete(c_idmap_t *m, c_id_t key)
+{
+  c_datum_t *slot, *next;
+  uint_t i, j, home;
+
+  if(!m || (key == 0LL))
+    return(FALSE);
+
+  slot = __C_idmap_probe(m, key);
+  if(__C_idmap_isempty(slot))
+    return(FALSE);
+
+  if(m->destructor && slot->value)
+    m->destructor(slot->value);
+
+  /* Close the gap by shifting back any following entries whose home slot
+     is at or before it, so that no tombstones are needed. */
+
+  for(i = (uint_t)(slot - m->slots), j = (i + 1) & m->mask;;
+      j = (j + 1) & m->mask)
+  {
+    next = &(m->slots[j]);
+    if(__C_idmap_isempty(next))
+      break;
+
+    home = __C_idmap_home(m, next->key);
+
+    /* next may move to i only if i lies cyclically in [home, j) */
+
+    if(((j - home) & m->mask) >= ((j - i) & m->mask))
+    {
+      m->slots[i] = *next;
+      i = j;
+    }
+  }
+
+  m->slots[i].key = 0;
+  m->slots[i].value = NULL;
+  --m->size;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_idmap_iterate(c_idmap_t *m,
+                         c_bool_t (*consumer)(c_id_t key, void *elem,
+                                              void *hook),
+                         void *hook)
+{
+  c_datum_t *slot;
+  uint_t i;
+
+  if(!m || !consumer)
+    return(FALSE);
+
+  for(i = 0, slot = m->slots; i <= m->mask; ++i, ++slot)
+  {
+    if(!__C_idmap_isempty(slot) && slot->value)
+    {
+      if(!consumer(slot->key, slot->value, hook))
+        return(FALSE);
+    }
+  }
+
+  return(TRUE);
+}
+
+/* end of source file */
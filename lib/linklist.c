@@ -30,7 +30,29 @@
 #include "cbase/data.h"
 #include "cbase/system.h"
 
-/* Functions */
+/* File scope functions */
+
+static c_link_t *__C_linklist_new_link(c_linklist_t *l)
+{
+  if(l->slab)
+    return((c_link_t *)C_slab_alloc(l->slab));
+
+  return(C_new(c_link_t));
+}
+
+/*
+ */
+
+static void __C_linklist_free_link(c_linklist_t *l, c_link_t *link)
+{
+  if(l->slab)
+    C_slab_free(l->slab, link);
+  else
+    C_free(link);
+}
+
+/*
+ */
 
 static c_link_t *__C_linklist_unlink_r(c_linklist_t *l, c_link_t **p)
 {
@@ -51,8 +73,7 @@ static c_link_t *__C_linklist_unlink_r(c_linklist_t *l, c_link_t **p)
   return(r);
 }
 
-/*
- */
+/* Functions */
 
 c_linklist_t *C_linklist_create(void)
 {
@@ -82,7 +103,7 @@ void C_linklist_destroy(c_linklist_t *l)
     if(l->destructor)
       l->destructor(q->data);
 
-    C_free(q);
+    __C_linklist_free_link(l, q);
   }
   C_free(l);
 }
@@ -100,6 +121,23 @@ c_bool_t C_linklist_set_destructor(c_linklist_t *l,
   return(TRUE);
 }
 
+/*
+ */
+
+c_bool_t C_linklist_set_slab(c_linklist_t *l, c_slab_t *slab)
+{
+  /* links already in the list came from the other allocator */
+
+  if(!l || l->size)
+    return(FALSE);
+
+  if(slab && (C_slab_objsize(slab) < sizeof(c_link_t)))
+    return(FALSE);
+
+  l->slab = slab;
+  return(TRUE);
+}
+
 /*
  */
 
@@ -121,7 +159,9 @@ c_bool_t C_linklist_store_r(c_linklist_t *l, const void *data, c_link_t **p)
   if(!l || !data)
     return(FALSE);
 
-  q = C_new(c_link_t);
+  if(!(q = __C_linklist_new_link(l)))
+    return(FALSE);
+
   q->data = (void *)data;
 
   if(*p == l->head) /* new head? */
@@ -238,7 +278,7 @@ void *C_linklist_pop(c_linklist_t *l)
   C_linklist_move_head_r(l, &p);
   q = __C_linklist_unlink_r(l, &p);
   r = q->data;
-  C_free(q);
+  __C_linklist_free_link(l, q);
 
   return(r);
 }
@@ -303,7 +343,7 @@ c_bool_t C_linklist_delete_r(c_linklist_t *l, c_link_t **p)
   if(l->destructor)
     l->destructor(r->data);
 
-  C_free(r);
+  __C_linklist_free_link(l, r);
 
   return(TRUE);
 }
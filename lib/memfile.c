@@ -55,9 +55,18 @@ static off_t __C_memfile_round_size(off_t size)
 /* Functions */
 
 c_memfile_t *C_memfile_open(const char *file, c_bool_t readonly)
+{
+  return(C_memfile_open_flags(file, (readonly ? C_MEMFILE_READONLY : 0)));
+}
+
+/*
+ */
+
+c_memfile_t *C_memfile_open_flags(const char *file, int flags)
 {
   c_memfile_t *f;
   struct stat stbuf;
+  c_bool_t readonly = (flags & C_MEMFILE_READONLY);
 
   if(!file)
     return(NULL);
@@ -65,13 +74,19 @@ c_memfile_t *C_memfile_open(const char *file, c_bool_t readonly)
   if(stat(file, &stbuf))
     return(NULL);
 
+  /* a private mapping is writable even if the file is not, since changes
+     are never written back to it */
+
   f = C_new(c_memfile_t);
-  if((f->fd = open(file, O_RDWR)) < 0)
+  f->flags = flags;
+  if((f->fd = open(file, ((readonly || (flags & C_MEMFILE_PRIVATE))
+                          ? O_RDONLY : O_RDWR))) < 0)
     return(C_free(f));
 
   f->length = stbuf.st_size;
   f->base = mmap(NULL, f->length,
-                 (readonly ? PROT_READ : (PROT_READ | PROT_WRITE)), MAP_SHARED,
+                 (readonly ? PROT_READ : (PROT_READ | PROT_WRITE)),
+                 ((flags & C_MEMFILE_PRIVATE) ? MAP_PRIVATE : MAP_SHARED),
                  f->fd, 0);
 
   if(f->base == MAP_FAILED)
@@ -111,18 +126,53 @@ c_bool_t C_memfile_close(c_memfile_t *mf)
 c_bool_t C_memfile_resize(c_memfile_t *mf, off_t length)
 {
   off_t newsize;
+  void *base;
 
-  if(!mf || (length < 0))
+  if(!mf || (length < 0)
+     || (mf->flags & (C_MEMFILE_READONLY | C_MEMFILE_PRIVATE)))
     return(FALSE);
 
   newsize = __C_memfile_round_size(length);
 
-  if(ftruncate(mf->fd, newsize))
+  /* The mapping cannot simply be extended in place, so the file is mapped
+     anew at its new size, and the old mapping is removed only once the
+     new one is in place; on failure, the file and the old mapping are
+     left as they were. A file that grows is extended before it is mapped
+     (any bytes added to it are zeroed by ftruncate()); one that shrinks
+     is truncated after it is mapped. Both mappings are shared mappings
+     of the same file, so the new one sees every page dirtied through the
+     old one, and nothing need be flushed first. The base address of the
+     mapping may change. */
+
+  if((newsize > mf->length) && ftruncate(mf->fd, newsize))
+    return(FALSE);
+
+  base = mmap(NULL, newsize, (PROT_READ | PROT_WRITE), MAP_SHARED, mf->fd, 0);
+
+  if(base == MAP_FAILED)
+  {
+    /* shrink the file back to its old size; should that fail as well,
+       there is no further recourse: the file is left longer than the
+       mapping, holding only zeroes past it, and the mapping is intact */
+
+    if(newsize > mf->length)
+    {
+      if(ftruncate(mf->fd, mf->length))
+        return(FALSE);
+    }
+
     return(FALSE);
+  }
+
+  if((newsize < mf->length) && ftruncate(mf->fd, newsize))
+  {
+    munmap(base, newsize);
+    return(FALSE);
+  }
 
-  if(newsize > mf->length)
-    memset(mf->base + mf->length, 0, (newsize - mf->length));
+  munmap(mf->base, mf->length);
 
+  mf->base = base;
   mf->length = newsize;
 
   return(TRUE);
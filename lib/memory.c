@@ -27,6 +27,7 @@
 /* System headers */
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Local headers */
@@ -95,6 +96,42 @@ void *C_mem_manage(void *p, size_t n, c_bool_t clearf)
   return(r);
 }
 
+/*
+ */
+
+void *C_mem_manage_aligned(size_t n, size_t align, c_bool_t clearf)
+{
+  void *r = NULL;
+
+  for(;;)
+  {
+    if(posix_memalign(&r, align, n) == 0)
+    {
+      if(__C_mem_alloc_hook)
+        __C_mem_alloc_hook(NULL, r, n);
+
+      if(clearf)
+        memset(r, 0, n);
+
+      break;
+    }
+    else
+    {
+      r = NULL;
+
+      if(__C_mem_errfunc)
+      {
+        if(! __C_mem_errfunc())
+          break;
+      }
+      else
+        break;
+    }
+  }
+
+  return(r);
+}
+
 /*
  */
 
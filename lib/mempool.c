@@ -32,6 +32,62 @@
 #include "cbase/defs.h"
 #include "cbase/system.h"
 
+/* Macros */
+
+/* Slab blocks are aligned on a cache line, and the block header is
+   padded to a full line, so that objects of a line or more in size,
+   which are rounded up to whole lines, never straddle one needlessly. */
+
+#define __C_SLAB_ALIGN 64
+
+#define __C_SLAB_DEFAULT_PERBLOCK 64
+
+/* File scope functions */
+
+static c_bool_t __C_slab_grow(c_slab_t *slab)
+{
+  void **block;
+
+  block = (void **)C_mem_manage_aligned(__C_SLAB_ALIGN
+                                        + (slab->perblock * slab->objsize),
+                                        __C_SLAB_ALIGN, FALSE);
+  if(! block)
+    return(FALSE);
+
+  /* the first word of each block links it to the previous one; objects
+     are carved from the rest of the block as they are needed, rather
+     than threaded onto the free list up front */
+
+  *block = slab->blocks;
+  slab->blocks = (void *)block;
+  slab->next = (char *)block + __C_SLAB_ALIGN;
+  slab->left = slab->perblock;
+  ++slab->nblocks;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static void __C_slab_release(c_slab_t *slab)
+{
+  void **block, **next;
+
+  for(block = (void **)slab->blocks; block; block = next)
+  {
+    next = (void **)*block;
+    C_free(block);
+  }
+
+  slab->blocks = NULL;
+  slab->free = NULL;
+  slab->next = NULL;
+  slab->left = 0;
+  slab->count = 0;
+  slab->nblocks = 0;
+}
+
 /* Functions */
 
 c_mempool_t *C_mempool_create(size_t size)
@@ -100,4 +156,94 @@ size_t C_mempool_avail(c_mempool_t *pool)
   return(pool->size - pool->pos);
 }
 
+/*
+ */
+
+c_slab_t *C_slab_create(size_t objsize, uint_t perblock)
+{
+  c_slab_t *slab;
+
+  if(objsize < 1)
+    return(NULL);
+
+  /* every object must be able to hold a free list link */
+
+  objsize = (objsize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  if(objsize >= __C_SLAB_ALIGN)
+    objsize = (objsize + __C_SLAB_ALIGN - 1) & ~(size_t)(__C_SLAB_ALIGN - 1);
+
+  slab = C_new(c_slab_t);
+  slab->objsize = objsize;
+  slab->perblock = perblock ? perblock : __C_SLAB_DEFAULT_PERBLOCK;
+
+  return(slab);
+}
+
+/*
+ */
+
+void C_slab_destroy(c_slab_t *slab)
+{
+  if(! slab)
+    return;
+
+  __C_slab_release(slab);
+  C_free(slab);
+}
+
+/*
+ */
+
+void *C_slab_alloc(c_slab_t *slab)
+{
+  void *p;
+
+  if(! slab)
+    return(NULL);
+
+  if(slab->free)
+  {
+    p = slab->free;
+    slab->free = *(void **)p;
+  }
+  else
+  {
+    if(! slab->left && ! __C_slab_grow(slab))
+      return(NULL);
+
+    p = (void *)slab->next;
+    slab->next += slab->objsize;
+    --slab->left;
+  }
+
+  ++slab->count;
+  memset(p, 0, slab->objsize);
+
+  return(p);
+}
+
+/*
+ */
+
+void C_slab_free(c_slab_t *slab, void *p)
+{
+  if(!slab || !p)
+    return;
+
+  *(void **)p = slab->free;
+  slab->free = p;
+  --slab->count;
+}
+
+/*
+ */
+
+void C_slab_reset(c_slab_t *slab)
+{
+  if(! slab)
+    return;
+
+  __C_slab_release(slab);
+}
+
 /* end of source file */
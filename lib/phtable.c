@@ -0,0 +1,536 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+#include "cbase/util.h"
+
+/* Macros */
+
+#define __C_PHTABLE_MAGIC "cbasePH"
+#define __C_PHTABLE_VERSION 1
+
+/* average number of keys per displacement bucket */
+
+#define __C_PHTABLE_LAMBDA 4
+
+/* A bucket's displacement word either holds the displacement that places
+   all of its keys in free slots, or, for a bucket holding a single key,
+   the slot itself, marked by the high bit. */
+
+#define __C_PHTABLE_DIRECT 0x80000000U
+#define __C_PHTABLE_MAX_KEYS 0x7FFFFFFFU
+
+#define __C_PHTABLE_MAX_DISP (1U << 20)
+#define __C_PHTABLE_MAX_ATTEMPTS 32
+
+#define __C_PHTABLE_FREE ((uint64_t)-1)
+
+#define __C_PHTABLE_GOLDEN 0x9E3779B97F4A7C15ULL
+
+#define __C_phtable_align(N) (((N) + 7) & ~(uint64_t)7)
+
+#define __C_phtable_bucket(V, R) ((uint_t)((V) % (R)))
+
+/* On-disk layout, in native byte order: the header, the displacement
+   array (one 32-bit word per bucket), the slot index (one 64-bit record
+   offset per key), and then the records, each 8-byte aligned. */
+
+typedef struct __c_phtable_header_t
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nbuckets;
+  uint64_t count;
+  uint64_t seed;
+  uint64_t disp_off;
+  uint64_t index_off;
+  uint64_t length;
+  uint64_t reserved;
+} __c_phtable_header_t;
+
+typedef struct __c_phtable_record_t
+{
+  uint64_t hash;
+  uint32_t keylen;
+  uint32_t vallen;
+} __c_phtable_record_t;
+
+typedef struct __c_phtable_entry_t
+{
+  const char *key;
+  size_t keylen;
+  const void *data;
+  size_t vallen;
+  uint64_t hash;
+  uint_t bucket;
+} __c_phtable_entry_t;
+
+typedef struct __c_phtable_bucket_t
+{
+  uint_t bucket;
+  uint_t first;
+  uint_t size;
+} __c_phtable_bucket_t;
+
+/* File scope functions */
+
+static uint64_t __C_phtable_slot(uint64_t hash, uint32_t disp, uint64_t n)
+{
+  uint64_t x = hash + (disp * __C_PHTABLE_GOLDEN);
+
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+
+  return(x % n);
+}
+
+/*
+ */
+
+static int __C_phtable_compare(const void *a, const void *b)
+{
+  const __c_phtable_bucket_t *ba = (const __c_phtable_bucket_t *)a;
+  const __c_phtable_bucket_t *bb = (const __c_phtable_bucket_t *)b;
+
+  /* largest buckets first, since they are the hardest to place */
+
+  if(ba->size != bb->size)
+    return((ba->size > bb->size) ? -1 : 1);
+
+  return((ba->bucket < bb->bucket) ? -1 : (ba->bucket > bb->bucket));
+}
+
+/* Computes a minimal perfect hash for the entries, with the given seed,
+   using the "hash, displace, and compress" method: keys are grouped into
+   buckets by hash, and each bucket, largest first, is assigned the first
+   displacement that maps all of its keys onto free slots. Fills in the
+   displacement array and the slot-to-entry map, and returns the number
+   of distinct keys, or 0 if this seed does not work. */
+
+static uint64_t __C_phtable_build(__c_phtable_entry_t *ent, uint_t count,
+                                  uint64_t seed, uint_t nbuckets,
+                                  uint32_t *disp, uint64_t *slotmap)
+{
+  __c_phtable_bucket_t *bkt;
+  uint_t *order, *fill, i, j, k, b, nb;
+  uint64_t n = 0, s;
+  uint32_t d;
+  c_bool_t ok = TRUE;
+
+  for(i = 0; i < count; ++i)
+  {
+    ent[i].hash = C_string_hash64_len(ent[i].key, ent[i].keylen, seed);
+    ent[i].bucket = __C_phtable_bucket(ent[i].hash, nbuckets);
+  }
+
+  /* group the entries by bucket */
+
+  bkt = C_calloc(nbuckets, __c_phtable_bucket_t);
+  fill = C_calloc(nbuckets, uint_t);
+  order = C_calloc(C_max(count, 1), uint_t);
+
+  for(i = 0; i < count; ++i)
+    ++bkt[ent[i].bucket].size;
+
+  for(b = 0, j = 0; b < nbuckets; ++b)
+  {
+    bkt[b].bucket = b;
+    bkt[b].first = j;
+    j += bkt[b].size;
+  }
+
+  for(i = 0; i < count; ++i)
+  {
+    b = ent[i].bucket;
+    order[bkt[b].first + fill[b]++] = i;
+  }
+
+  /* drop duplicate keys (a chained table may hold several), keeping the
+     one that appears first, which is the one the table returns; two
+     distinct keys with the same 64-bit hash cannot be separated, and
+     call for another seed */
+
+  for(b = 0; ok && (b < nbuckets); ++b)
+  {
+    for(i = 0; ok && (i < bkt[b].size); ++i)
+    {
+      __c_phtable_entry_t *e = &(ent[order[bkt[b].first + i]]);
+
+      for(j = i + 1; j < bkt[b].size; )
+      {
+        __c_phtable_entry_t *f = &(ent[order[bkt[b].first + j]]);
+
+        if(e->hash != f->hash)
+        {
+          ++j;
+          continue;
+        }
+
+        if((e->keylen != f->keylen) || memcmp(e->key, f->key, e->keylen))
+        {
+          ok = FALSE;
+          break;
+        }
+
+        for(k = j + 1; k < bkt[b].size; ++k)
+          order[bkt[b].first + k - 1] = order[bkt[b].first + k];
+
+        --bkt[b].size;
+      }
+    }
+
+    n += bkt[b].size;
+  }
+
+  if(ok && n)
+  {
+    for(s = 0; s < n; ++s)
+      slotmap[s] = __C_PHTABLE_FREE;
+
+    qsort(bkt, nbuckets, sizeof(__c_phtable_bucket_t), __C_phtable_compare);
+
+    for(nb = 0; (nb < nbuckets) && (bkt[nb].size > 1); ++nb)
+    {
+      for(d = 0; d < __C_PHTABLE_MAX_DISP; ++d)
+      {
+        for(i = 0; i < bkt[nb].size; ++i)
+        {
+          k = order[bkt[nb].first + i];
+          s = __C_phtable_slot(ent[k].hash, d, n);
+          if(slotmap[s] != __C_PHTABLE_FREE)
+            break;
+
+          slotmap[s] = k;
+        }
+
+        if(i == bkt[nb].size)
+          break;
+
+        /* collision; undo this attempt */
+
+        while(i--)
+          slotmap[__C_phtable_slot(ent[order[bkt[nb].first + i]].hash, d,
+                                   n)] = __C_PHTABLE_FREE;
+      }
+
+      if(d == __C_PHTABLE_MAX_DISP)
+      {
+        ok = FALSE;
+        break;
+      }
+
+      disp[bkt[nb].bucket] = d;
+    }
+
+    /* the remaining single-key buckets take the free slots directly */
+
+    for(s = 0; ok && (nb < nbuckets) && bkt[nb].size; ++nb)
+    {
+      while(slotmap[s] != __C_PHTABLE_FREE)
+        ++s;
+
+      slotmap[s] = order[bkt[nb].first];
+      disp[bkt[nb].bucket] = __C_PHTABLE_DIRECT | (uint32_t)s;
+    }
+  }
+
+  C_free(order);
+  C_free(fill);
+  C_free(bkt);
+
+  return(ok ? n : 0);
+}
+
+/*
+ */
+
+static c_bool_t __C_phtable_write(FILE *fp, const void *buf, size_t len,
+                                  uint64_t *off)
+{
+  static const char zeros[8] = { 0 };
+  size_t pad = (size_t)(__C_phtable_align(*off + len) - (*off + len));
+
+  if(len && (fwrite(buf, len, 1, fp) != 1))
+    return(FALSE);
+
+  if(pad && (fwrite(zeros, pad, 1, fp) != 1))
+    return(FALSE);
+
+  *off += len + pad;
+
+  return(TRUE);
+}
+
+/* Functions */
+
+c_bool_t C_hashtable_freeze(c_hashtable_t *h, const char *file,
+                            size_t (*valuelen)(const void *data))
+{
+  __c_phtable_header_t hdr;
+  __c_phtable_record_t rec;
+  __c_phtable_entry_t *ent, *e;
+  c_hashtable_iter_t iter;
+  uint32_t *disp = NULL;
+  uint64_t *slotmap = NULL, *index = NULL, n = 0, s, off, seed;
+  uint_t count, nbuckets, attempt;
+  c_bool_t ok = FALSE;
+  char *tmp;
+  FILE *fp;
+
+  if(!h || !file || (h->size > __C_PHTABLE_MAX_KEYS))
+    return(FALSE);
+
+  /* collect the entries; the keys stay in the table */
+
+  ent = C_calloc(C_max(h->size, 1), __c_phtable_entry_t);
+
+  C_hashtable_iter_init(h, &iter);
+  for(count = 0, e = ent;
+      C_hashtable_iter_next(&iter, &(e->key), &(e->keylen),
+                            (void **)&(e->data));
+      ++count, ++e)
+  {
+    e->vallen = valuelen ? valuelen(e->data) : (strlen(e->data) + 1);
+  }
+
+  nbuckets = C_max(count / __C_PHTABLE_LAMBDA, 1);
+  disp = C_calloc(nbuckets, uint32_t);
+  slotmap = C_calloc(C_max(count, 1), uint64_t);
+
+  /* a seed for which no displacement can be found is rare; try another */
+
+  for(attempt = 0, seed = h->seed;
+      count && (attempt < __C_PHTABLE_MAX_ATTEMPTS);
+      ++attempt, seed += __C_PHTABLE_GOLDEN)
+  {
+    memset(disp, 0, nbuckets * sizeof(uint32_t));
+
+    if((n = __C_phtable_build(ent, count, seed, nbuckets, disp,
+                              slotmap)) != 0)
+      break;
+  }
+
+  if(count && !n)
+    goto CLEANUP;
+
+  C_zero(&hdr, __c_phtable_header_t);
+  memcpy(hdr.magic, __C_PHTABLE_MAGIC, sizeof(hdr.magic));
+  hdr.version = __C_PHTABLE_VERSION;
+  hdr.nbuckets = nbuckets;
+  hdr.count = n;
+  hdr.seed = seed;
+  hdr.disp_off = sizeof(__c_phtable_header_t);
+  hdr.index_off = __C_phtable_align(hdr.disp_off
+                                    + (nbuckets * sizeof(uint32_t)));
+
+  /* lay out the records in slot order */
+
+  index = C_calloc(C_max(n, 1), uint64_t);
+  off = hdr.index_off + (n * sizeof(uint64_t));
+
+  for(s = 0; s < n; ++s)
+  {
+    e = &(ent[slotmap[s]]);
+    index[s] = off;
+    off = __C_phtable_align(off + sizeof(__c_phtable_record_t) + e->keylen
+                            + 1 + e->vallen);
+  }
+
+  hdr.length = off;
+
+  /* write to a temporary file and rename it into place, so that readers
+     never map a partially written table */
+
+  tmp = C_string_va_make(file, ".tmp", NULL);
+
+  if(!(fp = fopen(tmp, "wb")))
+  {
+    C_free(tmp);
+    goto CLEANUP;
+  }
+
+  off = 0;
+  ok = __C_phtable_write(fp, &hdr, sizeof(hdr), &off)
+    && __C_phtable_write(fp, disp, nbuckets * sizeof(uint32_t), &off)
+    && __C_phtable_write(fp, index, n * sizeof(uint64_t), &off);
+
+  for(s = 0; ok && (s < n); ++s)
+  {
+    e = &(ent[slotmap[s]]);
+    rec.hash = e->hash;
+    rec.keylen = (uint32_t)e->keylen;
+    rec.vallen = (uint32_t)e->vallen;
+
+    ok = (fwrite(&rec, sizeof(rec), 1, fp) == 1)
+      && (fwrite(e->key, e->keylen, 1, fp) == 1)
+      && (fputc(NUL, fp) != EOF);
+
+    off += sizeof(rec) + e->keylen + 1;
+    ok = ok && __C_phtable_write(fp, e->data, e->vallen, &off);
+  }
+
+  if(fclose(fp) || !ok || rename(tmp, file))
+  {
+    unlink(tmp);
+    ok = FALSE;
+  }
+
+  C_free(tmp);
+
+CLEANUP:
+
+  C_free(index);
+  C_free(slotmap);
+  C_free(disp);
+  C_free(ent);
+
+  return(ok);
+}
+
+/*
+ */
+
+c_phtable_t *C_phtable_open(const char *file)
+{
+  c_phtable_t *t;
+  c_memfile_t *mf;
+  const __c_phtable_header_t *hdr;
+
+  if(!(mf = C_memfile_open(file, TRUE)))
+    return(NULL);
+
+  /* validate the header against the file, so that lookups need not */
+
+  hdr = (const __c_phtable_header_t *)C_memfile_base(mf);
+
+  if((C_memfile_length(mf) < sizeof(__c_phtable_header_t))
+     || memcmp(hdr->magic, __C_PHTABLE_MAGIC, sizeof(hdr->magic))
+     || (hdr->version != __C_PHTABLE_VERSION)
+     || (hdr->length != (uint64_t)C_memfile_length(mf))
+     || !hdr->nbuckets
+     || (hdr->count > __C_PHTABLE_MAX_KEYS)
+     || (hdr->disp_off + ((uint64_t)hdr->nbuckets * sizeof(uint32_t))
+         > hdr->index_off)
+     || (hdr->index_off + (hdr->count * sizeof(uint64_t)) > hdr->length))
+  {
+    C_memfile_close(mf);
+    return(NULL);
+  }
+
+  t = C_new(c_phtable_t);
+  t->file = mf;
+  t->base = (const char *)C_memfile_base(mf);
+  t->length = C_memfile_length(mf);
+  t->size = (size_t)hdr->count;
+  t->nbuckets = hdr->nbuckets;
+  t->seed = hdr->seed;
+  t->disp = (const uint32_t *)(t->base + hdr->disp_off);
+  t->index = (const uint64_t *)(t->base + hdr->index_off);
+
+  return(t);
+}
+
+/*
+ */
+
+c_bool_t C_phtable_close(c_phtable_t *t)
+{
+  c_bool_t r;
+
+  if(!t)
+    return(FALSE);
+
+  r = C_memfile_close(t->file);
+  C_free(t);
+
+  return(r);
+}
+
+/*
+ */
+
+const void *C_phtable_restore(c_phtable_t *t, const char *key)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_phtable_restore_len(t, key, strlen(key), NULL));
+}
+
+/*
+ */
+
+const void *C_phtable_restore_len(c_phtable_t *t, const void *key,
+                                  size_t len, size_t *vallen)
+{
+  const __c_phtable_record_t *rec;
+  uint64_t hash, off;
+  uint32_t d;
+
+  if(!t || !key || !len || !t->size)
+    return(NULL);
+
+  hash = C_string_hash64_len(key, len, t->seed);
+  d = t->disp[__C_phtable_bucket(hash, t->nbuckets)];
+
+  off = t->index[(d & __C_PHTABLE_DIRECT)
+                 ? (uint64_t)(d & ~__C_PHTABLE_DIRECT) % t->size
+                 : __C_phtable_slot(hash, d, t->size)];
+
+  /* every key maps to some record; compare to reject absent keys */
+
+  if((off + sizeof(__c_phtable_record_t)) > t->length)
+    return(NULL);
+
+  rec = (const __c_phtable_record_t *)(t->base + off);
+
+  if((rec->hash != hash) || (rec->keylen != len)
+     || ((off + sizeof(__c_phtable_record_t) + len + 1 + rec->vallen)
+         > t->length)
+     || memcmp((const char *)(rec + 1), key, len))
+    return(NULL);
+
+  if(vallen)
+    *vallen = rec->vallen;
+
+  return((const char *)(rec + 1) + len + 1);
+}
+
+/* end of source file */
@@ -0,0 +1,292 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_RINGQUEUE_ALIGN C_RINGQUEUE_LINE
+
+#define __C_RINGQUEUE_MIN_CAPACITY 2
+
+/* Every slot carries a sequence number, which tells the position in the
+   queue at which it may next be used: a slot at position P may be filled
+   when its sequence number is P, and emptied when it is P + 1, after
+   which its sequence number becomes P + capacity, the position at which
+   it next comes around. Producers claim a position by advancing the tail
+   with a compare-and-swap, and consumers likewise the head; a slot is
+   then filled or emptied, and published by storing its new sequence
+   number with release semantics. With a single producer (or consumer),
+   the tail (or head) is advanced with a plain store instead. */
+
+#ifdef THREADED_LIBRARY
+
+#define __C_ringqueue_load(P)                   \
+  __atomic_load_n((P), __ATOMIC_RELAXED)
+#define __C_ringqueue_store(P, V)               \
+  __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+#define __C_ringqueue_load_acquire(P)           \
+  __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define __C_ringqueue_store_release(P, V)       \
+  __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define __C_ringqueue_cas(P, E, V)                                      \
+  __atomic_compare_exchange_n((P), (E), (V), FALSE, __ATOMIC_RELAXED,   \
+                              __ATOMIC_RELAXED)
+
+#else
+
+#define __C_ringqueue_load(P) (*(P))
+#define __C_ringqueue_store(P, V) (*(P) = (V))
+#define __C_ringqueue_load_acquire(P) (*(P))
+#define __C_ringqueue_store_release(P, V) (*(P) = (V))
+#define __C_ringqueue_cas(P, E, V)                                      \
+  ((*(P) == *(E)) ? ((*(P) = (V)), TRUE) : ((*(E) = *(P)), FALSE))
+
+#endif /* THREADED_LIBRARY */
+
+typedef struct __c_ringqueue_slot_t
+{
+  uint64_t seq;
+  void *data;
+} __c_ringqueue_slot_t;
+
+#define __C_ringqueue_slot(Q, P)                                \
+  (((__c_ringqueue_slot_t *)(Q)->slots) + ((P) & (Q)->mask))
+
+/* File scope functions */
+
+/* Claim up to n consecutive positions, beginning at the position
+   *pos, in which each slot's sequence number is the position plus
+   offset; returns the number of positions claimed, and the first of them
+   at pos. */
+
+static uint_t __C_ringqueue_claim(c_ringqueue_t *q, uint64_t *end,
+                                  c_bool_t single, uint64_t offset,
+                                  uint_t n, uint64_t *pos)
+{
+  uint64_t p, seq;
+  uint_t k;
+
+  if(n == 0)
+    return(0);
+
+  p = __C_ringqueue_load(end);
+
+  for(;;)
+  {
+    for(k = 0; k < n; ++k)
+    {
+      seq = __C_ringqueue_load_acquire(&(__C_ringqueue_slot(q, p + k)->seq));
+      if(seq != (p + k + offset))
+        break;
+    }
+
+    if(k == 0)
+    {
+      /* the slot is either not ready yet, or was claimed by another
+         thread since the end was read; in the latter case, try again */
+
+      seq = __C_ringqueue_load_acquire(&(__C_ringqueue_slot(q, p)->seq));
+      if((int64_t)(seq - (p + offset)) < 0)
+        return(0);
+
+      p = __C_ringqueue_load(end);
+      continue;
+    }
+
+    if(single)
+    {
+      __C_ringqueue_store(end, p + k);
+      break;
+    }
+
+    if(__C_ringqueue_cas(end, &p, p + k))
+      break;
+  }
+
+  *pos = p;
+
+  return(k);
+}
+
+/* Functions */
+
+c_ringqueue_t *C_ringqueue_create(uint_t capacity, int flags)
+{
+  c_ringqueue_t *q;
+  __c_ringqueue_slot_t *slot;
+  uint_t size, i;
+
+  if((capacity < 1) || (capacity > (1U << 31)))
+    return(NULL);
+
+  for(size = __C_RINGQUEUE_MIN_CAPACITY; size < capacity; size <<= 1);
+
+  /* the head and the tail are kept in separate cache lines, so that
+     producers and consumers do not contend for the same line */
+
+  q = (c_ringqueue_t *)C_mem_manage_aligned(sizeof(c_ringqueue_t),
+                                            __C_RINGQUEUE_ALIGN, TRUE);
+  q->slots = C_mem_manage_aligned(size * sizeof(__c_ringqueue_slot_t),
+                                  __C_RINGQUEUE_ALIGN, FALSE);
+  q->mask = size - 1;
+  q->flags = flags;
+  q->head = q->tail = 0;
+
+  for(i = 0, slot = (__c_ringqueue_slot_t *)q->slots; i < size; ++i, ++slot)
+  {
+    slot->seq = i;
+    slot->data = NULL;
+  }
+
+  return(q);
+}
+
+/*
+ */
+
+void C_ringqueue_destroy(c_ringqueue_t *q)
+{
+  if(! q)
+    return;
+
+  C_free(q->slots);
+  C_free(q);
+}
+
+/*
+ */
+
+c_bool_t C_ringqueue_enqueue(c_ringqueue_t *q, const void *data)
+{
+  if(!q || !data)
+    return(FALSE);
+
+  return(C_ringqueue_enqueue_batch(q, (void * const *)&data, 1) == 1);
+}
+
+/*
+ */
+
+void *C_ringqueue_dequeue(c_ringqueue_t *q)
+{
+  void *data;
+
+  if(! q)
+    return(NULL);
+
+  if(C_ringqueue_dequeue_batch(q, &data, 1) != 1)
+    return(NULL);
+
+  return(data);
+}
+
+/*
+ */
+
+uint_t C_ringqueue_enqueue_batch(c_ringqueue_t *q, void * const *data,
+                                 uint_t n)
+{
+  __c_ringqueue_slot_t *slot;
+  uint64_t pos;
+  uint_t i, k;
+
+  if(!q || !data)
+    return(0);
+
+  for(i = 0; i < n; ++i)
+  {
+    if(! data[i])
+      return(0);
+  }
+
+  k = __C_ringqueue_claim(q, &(q->tail),
+                          (q->flags & C_RINGQUEUE_SINGLE_PRODUCER), 0,
+                          C_min(n, q->mask + 1), &pos);
+
+  for(i = 0; i < k; ++i)
+  {
+    slot = __C_ringqueue_slot(q, pos + i);
+    slot->data = data[i];
+    __C_ringqueue_store_release(&(slot->seq), pos + i + 1);
+  }
+
+  return(k);
+}
+
+/*
+ */
+
+uint_t C_ringqueue_dequeue_batch(c_ringqueue_t *q, void **data, uint_t n)
+{
+  __c_ringqueue_slot_t *slot;
+  uint64_t pos;
+  uint_t i, k;
+
+  if(!q || !data)
+    return(0);
+
+  k = __C_ringqueue_claim(q, &(q->head),
+                          (q->flags & C_RINGQUEUE_SINGLE_CONSUMER), 1,
+                          C_min(n, q->mask + 1), &pos);
+
+  for(i = 0; i < k; ++i)
+  {
+    slot = __C_ringqueue_slot(q, pos + i);
+    data[i] = slot->data;
+    __C_ringqueue_store_release(&(slot->seq), pos + i + q->mask + 1);
+  }
+
+  return(k);
+}
+
+/*
+ */
+
+size_t C_ringqueue_length(c_ringqueue_t *q)
+{
+  uint64_t head, tail;
+
+  if(! q)
+    return(0);
+
+  /* the result is only a snapshot while other threads are active */
+
+  head = __C_ringqueue_load(&(q->head));
+  tail = __C_ringqueue_load(&(q->tail));
+
+  return((tail > head) ? (size_t)(tail - head) : 0);
+}
+
+/* end of source file */
@@ -0,0 +1,974 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <string.h>
+
+/* Local headers */
+
+#include "cbase/defs.h"
+#include "cbase/data.h"
+#include "cbase/system.h"
+
+/* Macros */
+
+#define __C_SBTREE_INSERTED 0
+#define __C_SBTREE_DUPLICATE 1
+#define __C_SBTREE_SPLIT 2
+#define __C_SBTREE_DELETED 3
+#define __C_SBTREE_UNDERFLOW 4
+#define __C_SBTREE_NOTFOUND 5
+
+/* Keys are kept in leaves, each with its value, and leaves are linked to
+   their neighbors. Interior nodes hold separators, each of which is
+   only as long as it needs to be to fall between the last key in the
+   subtree to its left and the first key in the subtree to its right,
+   rather than a copy of a whole key. Every key and separator is a
+   separately allocated, NUL-terminated copy owned by its node.
+
+   A node has room for one more key than its capacity, so that a key may
+   be inserted into a full node before it is split. */
+
+typedef struct __c_sbtree_node_t
+{
+  uint_t count;
+  c_bool_t leaf;
+  struct __c_sbtree_node_t *next;
+  struct __c_sbtree_node_t *prev;
+  char **keys;
+  size_t *lens;
+  void **slots; /* values in a leaf, children in an interior node */
+} __c_sbtree_node_t;
+
+#define __C_sbtree_compare(T, K1, L1, K2, L2)   \
+  ((T)->compare((K1), (L1), (K2), (L2)))
+
+/* File scope functions */
+
+static int __C_sbtree_compare_bytes(const void *key1, size_t len1,
+                                    const void *key2, size_t len2)
+{
+  int r;
+
+  r = memcmp(key1, key2, C_min(len1, len2));
+
+  if(r)
+    return(r);
+
+  return((len1 < len2) ? -1 : (len1 > len2));
+}
+
+/*
+ */
+
+static __c_sbtree_node_t *__C_sbtree_create_node(c_sbtree_t *tree,
+                                                 c_bool_t leaf)
+{
+  __c_sbtree_node_t *node;
+  char *p;
+
+  p = (char *)C_newb(sizeof(__c_sbtree_node_t)
+                     + ((tree->nkeys + 1) * (sizeof(char *) + sizeof(size_t)))
+                     + ((tree->nkeys + 2) * sizeof(void *)));
+
+  node = (__c_sbtree_node_t *)p;
+  p += sizeof(__c_sbtree_node_t);
+  node->keys = (char **)p;
+  p += (tree->nkeys + 1) * sizeof(char *);
+  node->lens = (size_t *)p;
+  p += (tree->nkeys + 1) * sizeof(size_t);
+  node->slots = (void **)p;
+  node->leaf = leaf;
+
+  return(node);
+}
+
+/*
+ */
+
+static void __C_sbtree_destroy_node(c_sbtree_t *tree, __c_sbtree_node_t *node)
+{
+  uint_t i;
+
+  for(i = 0; i < node->count; ++i)
+  {
+    C_free(node->keys[i]);
+
+    if(node->leaf && tree->destructor && node->slots[i])
+      tree->destructor(node->slots[i]);
+  }
+
+  if(! node->leaf)
+  {
+    for(i = 0; i <= node->count; ++i)
+      __C_sbtree_destroy_node(tree, (__c_sbtree_node_t *)node->slots[i]);
+  }
+
+  C_free(node);
+}
+
+/*
+ */
+
+static char *__C_sbtree_keydup(const void *key, size_t len)
+{
+  char *s = C_newstr(len);
+
+  memcpy(s, key, len);
+
+  return(s);
+}
+
+/*
+ */
+
+static uint_t __C_sbtree_search(c_sbtree_t *tree, __c_sbtree_node_t *node,
+                                const void *key, size_t len)
+{
+  uint_t lo = 0, hi = node->count, mid;
+
+  /* Returns the index of the first key not less than key. */
+
+  while(lo < hi)
+  {
+    mid = (lo + hi) / 2;
+
+    if(__C_sbtree_compare(tree, node->keys[mid], node->lens[mid], key, len) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return(lo);
+}
+
+/*
+ */
+
+static uint_t __C_sbtree_child(c_sbtree_t *tree, __c_sbtree_node_t *node,
+                               const void *key, size_t len)
+{
+  uint_t i = __C_sbtree_search(tree, node, key, len);
+
+  /* a separator is not greater than any key in the subtree to its
+     right */
+
+  if((i < node->count)
+     && ! __C_sbtree_compare(tree, node->keys[i], node->lens[i], key, len))
+    ++i;
+
+  return(i);
+}
+
+/*
+ */
+
+static char *__C_sbtree_separator(c_sbtree_t *tree,
+                                  const char *left, size_t llen,
+                                  const char *right, size_t rlen,
+                                  size_t *len)
+{
+  size_t n = 0;
+
+  /* Finds the shortest prefix of right that is greater than left, which
+     is a valid separator since it is also no greater than right. Under
+     bytewise ordering this is the common prefix plus one byte; other
+     comparators are checked from there, falling back to all of right. */
+
+  while((n < llen) && (n < rlen) && (left[n] == right[n]))
+    ++n;
+
+  for(++n; n < rlen; ++n)
+  {
+    if((__C_sbtree_compare(tree, left, llen, right, n) < 0)
+       && (__C_sbtree_compare(tree, right, n, right, rlen) <= 0))
+      break;
+  }
+
+  if(n > rlen)
+    n = rlen;
+
+  *len = n;
+
+  return(__C_sbtree_keydup(right, n));
+}
+
+/*
+ */
+
+static void __C_sbtree_insert_at(__c_sbtree_node_t *node, uint_t i,
+                                 char *key, size_t len, void *slot)
+{
+  uint_t s = node->leaf ? i : (i + 1);
+
+  /* In a leaf, the slot is the key's value; in an interior node, it is
+     the child to the right of the separator. */
+
+  memmove(node->keys + i + 1, node->keys + i,
+          (node->count - i) * sizeof(char *));
+  memmove(node->lens + i + 1, node->lens + i,
+          (node->count - i) * sizeof(size_t));
+  memmove(node->slots + s + 1, node->slots + s,
+          (node->count + 1 - s) * sizeof(void *));
+
+  node->keys[i] = key;
+  node->lens[i] = len;
+  node->slots[s] = slot;
+  ++node->count;
+}
+
+/*
+ */
+
+static void __C_sbtree_remove_at(__c_sbtree_node_t *node, uint_t i)
+{
+  uint_t s = node->leaf ? i : (i + 1);
+
+  --node->count;
+
+  memmove(node->keys + i, node->keys + i + 1,
+          (node->count - i) * sizeof(char *));
+  memmove(node->lens + i, node->lens + i + 1,
+          (node->count - i) * sizeof(size_t));
+  memmove(node->slots + s, node->slots + s + 1,
+          (node->count + 1 - s) * sizeof(void *));
+}
+
+/*
+ */
+
+static __c_sbtree_node_t *__C_sbtree_split(c_sbtree_t *tree,
+                                           __c_sbtree_node_t *node,
+                                           char **rkey, size_t *rlen)
+{
+  __c_sbtree_node_t *right;
+  uint_t m, n;
+
+  /* Splits the overfull node in two, returning the new right half and
+     the separator to be added to the parent. */
+
+  right = __C_sbtree_create_node(tree, node->leaf);
+  m = node->count / 2;
+
+  if(node->leaf)
+  {
+    n = node->count - m;
+
+    memcpy(right->keys, node->keys + m, n * sizeof(char *));
+    memcpy(right->lens, node->lens + m, n * sizeof(size_t));
+    memcpy(right->slots, node->slots + m, n * sizeof(void *));
+
+    right->count = n;
+    node->count = m;
+
+    right->next = node->next;
+    right->prev = node;
+
+    if(node->next)
+      node->next->prev = right;
+
+    node->next = right;
+
+    *rkey = __C_sbtree_separator(tree, node->keys[m - 1], node->lens[m - 1],
+                                 right->keys[0], right->lens[0], rlen);
+  }
+  else
+  {
+    /* the middle separator moves up to the parent */
+
+    n = node->count - m - 1;
+
+    memcpy(right->keys, node->keys + m + 1, n * sizeof(char *));
+    memcpy(right->lens, node->lens + m + 1, n * sizeof(size_t));
+    memcpy(right->slots, node->slots + m + 1, (n + 1) * sizeof(void *));
+
+    right->count = n;
+    node->count = m;
+
+    *rkey = node->keys[m];
+    *rlen = node->lens[m];
+  }
+
+  return(right);
+}
+
+/*
+ */
+
+static int __C_sbtree_insert_node(c_sbtree_t *tree, __c_sbtree_node_t *node,
+                                  const void *key, size_t len, void *data,
+                                  char **rkey, size_t *rlen,
+                                  __c_sbtree_node_t **rnode)
+{
+  uint_t i;
+  int r;
+
+  if(node->leaf)
+  {
+    i = __C_sbtree_search(tree, node, key, len);
+
+    if((i < node->count)
+       && ! __C_sbtree_compare(tree, node->keys[i], node->lens[i], key, len))
+      return(__C_SBTREE_DUPLICATE);
+
+    __C_sbtree_insert_at(node, i, __C_sbtree_keydup(key, len), len, data);
+  }
+  else
+  {
+    i = __C_sbtree_child(tree, node, key, len);
+
+    r = __C_sbtree_insert_node(tree, (__c_sbtree_node_t *)node->slots[i], key,
+                               len, data, rkey, rlen, rnode);
+
+    if(r != __C_SBTREE_SPLIT)
+      return(r);
+
+    __C_sbtree_insert_at(node, i, *rkey, *rlen, *rnode);
+  }
+
+  if(node->count <= tree->nkeys)
+    return(__C_SBTREE_INSERTED);
+
+  *rnode = __C_sbtree_split(tree, node, rkey, rlen);
+
+  return(__C_SBTREE_SPLIT);
+}
+
+/*
+ */
+
+static void __C_sbtree_rebalance(c_sbtree_t *tree, __c_sbtree_node_t *parent,
+                                 uint_t i)
+{
+  __c_sbtree_node_t *left, *right;
+  uint_t s, lc;
+
+  /* Child i has underflowed. Borrow from its left sibling, or from its
+     right sibling if it is the leftmost child; if the sibling has
+     nothing to spare, merge the two. s is the index of the separator
+     between them. */
+
+  s = (i > 0) ? (i - 1) : 0;
+  left = (__c_sbtree_node_t *)parent->slots[s];
+  right = (__c_sbtree_node_t *)parent->slots[s + 1];
+  lc = left->count;
+
+  if(left->leaf)
+  {
+    if(((i > 0) && (lc > tree->order))
+       || ((i == 0) && (right->count > tree->order)))
+    {
+      if(i > 0)
+      {
+        __C_sbtree_insert_at(right, 0, left->keys[lc - 1],
+                             left->lens[lc - 1], left->slots[lc - 1]);
+        --left->count;
+      }
+      else
+      {
+        __C_sbtree_insert_at(left, lc, right->keys[0], right->lens[0],
+                             right->slots[0]);
+        __C_sbtree_remove_at(right, 0);
+      }
+
+      /* the boundary between the leaves has moved */
+
+      C_free(parent->keys[s]);
+      parent->keys[s] = __C_sbtree_separator(
+        tree, left->keys[left->count - 1], left->lens[left->count - 1],
+        right->keys[0], right->lens[0], &(parent->lens[s]));
+
+      return;
+    }
+
+    memcpy(left->keys + lc, right->keys, right->count * sizeof(char *));
+    memcpy(left->lens + lc, right->lens, right->count * sizeof(size_t));
+    memcpy(left->slots + lc, right->slots, right->count * sizeof(void *));
+    left->count += right->count;
+
+    left->next = right->next;
+
+    if(right->next)
+      right->next->prev = left;
+
+    C_free(parent->keys[s]);
+  }
+  else
+  {
+    if((i > 0) && (lc > tree->order))
+    {
+      /* rotate right through the parent */
+
+      memmove(right->keys + 1, right->keys, right->count * sizeof(char *));
+      memmove(right->lens + 1, right->lens, right->count * sizeof(size_t));
+      memmove(right->slots + 1, right->slots,
+              (right->count + 1) * sizeof(void *));
+
+      right->keys[0] = parent->keys[s];
+      right->lens[0] = parent->lens[s];
+      right->slots[0] = left->slots[lc];
+      ++right->count;
+
+      parent->keys[s] = left->keys[lc - 1];
+      parent->lens[s] = left->lens[lc - 1];
+      --left->count;
+
+      return;
+    }
+
+    if((i == 0) && (right->count > tree->order))
+    {
+      /* rotate left through the parent */
+
+      __C_sbtree_insert_at(left, lc, parent->keys[s], parent->lens[s],
+                           right->slots[0]);
+
+      parent->keys[s] = right->keys[0];
+      parent->lens[s] = right->lens[0];
+
+      memmove(right->slots, right->slots + 1, right->count * sizeof(void *));
+      memmove(right->keys, right->keys + 1,
+              (right->count - 1) * sizeof(char *));
+      memmove(right->lens, right->lens + 1,
+              (right->count - 1) * sizeof(size_t));
+      --right->count;
+
+      return;
+    }
+
+    /* the separator comes down between the merged halves */
+
+    left->keys[lc] = parent->keys[s];
+    left->lens[lc] = parent->lens[s];
+
+    memcpy(left->keys + lc + 1, right->keys, right->count * sizeof(char *));
+    memcpy(left->lens + lc + 1, right->lens, right->count * sizeof(size_t));
+    memcpy(left->slots + lc + 1, right->slots,
+           (right->count + 1) * sizeof(void *));
+    left->count += right->count + 1;
+  }
+
+  /* the right node has been merged into the left; drop it */
+
+  __C_sbtree_remove_at(parent, s);
+  C_free(right);
+}
+
+/*
+ */
+
+static int __C_sbtree_delete_node(c_sbtree_t *tree, __c_sbtree_node_t *node,
+                                  const void *key, size_t len)
+{
+  uint_t i;
+  int r;
+
+  if(node->leaf)
+  {
+    i = __C_sbtree_search(tree, node, key, len);
+
+    if((i == node->count)
+       || __C_sbtree_compare(tree, node->keys[i], node->lens[i], key, len))
+      return(__C_SBTREE_NOTFOUND);
+
+    if(tree->destructor && node->slots[i])
+      tree->destructor(node->slots[i]);
+
+    C_free(node->keys[i]);
+    __C_sbtree_remove_at(node, i);
+  }
+  else
+  {
+    i = __C_sbtree_child(tree, node, key, len);
+
+    r = __C_sbtree_delete_node(tree, (__c_sbtree_node_t *)node->slots[i], key,
+                               len);
+
+    if(r != __C_SBTREE_UNDERFLOW)
+      return(r);
+
+    __C_sbtree_rebalance(tree, node, i);
+  }
+
+  return((node->count < tree->order)
+         ? __C_SBTREE_UNDERFLOW : __C_SBTREE_DELETED);
+}
+
+/*
+ */
+
+static __c_sbtree_node_t *__C_sbtree_find_leaf(c_sbtree_t *tree,
+                                               const void *key, size_t len)
+{
+  __c_sbtree_node_t *node = (__c_sbtree_node_t *)tree->root;
+
+  while(node && ! node->leaf)
+    node = (__c_sbtree_node_t *)node->slots[
+      __C_sbtree_child(tree, node, key, len)];
+
+  return(node);
+}
+
+/*
+ */
+
+static __c_sbtree_node_t *__C_sbtree_edge_leaf(c_sbtree_t *tree,
+                                               c_bool_t last)
+{
+  __c_sbtree_node_t *node = (__c_sbtree_node_t *)tree->root;
+
+  while(node && ! node->leaf)
+    node = (__c_sbtree_node_t *)node->slots[last ? node->count : 0];
+
+  return(node);
+}
+
+/*
+ */
+
+static c_bool_t __C_sbtree_cursor_check(c_sbtree_cursor_t *cursor)
+{
+  __c_sbtree_node_t *node = (__c_sbtree_node_t *)cursor->node;
+
+  /* a position past the end of a leaf is the start of the next one, and
+     an element at or beyond the limit ends the scan */
+
+  while(node && (cursor->pos >= node->count))
+  {
+    node = node->next;
+    cursor->pos = 0;
+  }
+
+  if(node && cursor->limit
+     && (__C_sbtree_compare(cursor->tree, node->keys[cursor->pos],
+                            node->lens[cursor->pos], cursor->limit,
+                            cursor->limitlen) >= 0))
+    node = NULL;
+
+  cursor->node = node;
+
+  return(node != NULL);
+}
+
+/* Functions */
+
+c_sbtree_t *C_sbtree_create(uint_t order)
+{
+  c_sbtree_t *tree;
+
+  if(order < 2)
+    return(NULL);
+
+  tree = C_new(c_sbtree_t);
+  tree->order = order;
+  tree->nkeys = order * 2;
+  tree->compare = __C_sbtree_compare_bytes;
+
+  return(tree);
+}
+
+/*
+ */
+
+void C_sbtree_destroy(c_sbtree_t *tree)
+{
+  if(!tree)
+    return;
+
+  if(tree->root)
+    __C_sbtree_destroy_node(tree, (__c_sbtree_node_t *)tree->root);
+
+  C_free(tree);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_set_destructor(c_sbtree_t *tree, void (*destructor)(void *))
+{
+  if(!tree)
+    return(FALSE);
+
+  tree->destructor = destructor;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_set_comparator(c_sbtree_t *tree, c_compfunc_t compare)
+{
+  /* the order of the keys cannot change once there are any */
+
+  if(!tree || tree->size)
+    return(FALSE);
+
+  tree->compare = compare ? compare : __C_sbtree_compare_bytes;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_store(c_sbtree_t *tree, const char *key, const void *data)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_sbtree_store_len(tree, key, strlen(key), data));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_store_len(c_sbtree_t *tree, const void *key, size_t len,
+                            const void *data)
+{
+  __c_sbtree_node_t *root, *rnode;
+  char *rkey;
+  size_t rlen;
+  int r;
+
+  if(!tree || !key)
+    return(FALSE);
+
+  if(!tree->root)
+    tree->root = __C_sbtree_create_node(tree, TRUE);
+
+  r = __C_sbtree_insert_node(tree, (__c_sbtree_node_t *)tree->root, key, len,
+                             (void *)data, &rkey, &rlen, &rnode);
+
+  if(r == __C_SBTREE_DUPLICATE)
+    return(FALSE);
+
+  if(r == __C_SBTREE_SPLIT)
+  {
+    /* the root split; grow the tree by one level */
+
+    root = __C_sbtree_create_node(tree, FALSE);
+    root->count = 1;
+    root->keys[0] = rkey;
+    root->lens[0] = rlen;
+    root->slots[0] = tree->root;
+    root->slots[1] = rnode;
+
+    tree->root = root;
+  }
+
+  ++tree->size;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+void *C_sbtree_restore(c_sbtree_t *tree, const char *key)
+{
+  if(!key)
+    return(NULL);
+
+  return(C_sbtree_restore_len(tree, key, strlen(key)));
+}
+
+/*
+ */
+
+void *C_sbtree_restore_len(c_sbtree_t *tree, const void *key, size_t len)
+{
+  __c_sbtree_node_t *node;
+  uint_t i;
+
+  if(!tree || !key)
+    return(NULL);
+
+  if(!(node = __C_sbtree_find_leaf(tree, key, len)))
+    return(NULL);
+
+  i = __C_sbtree_search(tree, node, key, len);
+
+  if((i < node->count)
+     && ! __C_sbtree_compare(tree, node->keys[i], node->lens[i], key, len))
+    return(node->slots[i]);
+
+  return(NULL);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_delete(c_sbtree_t *tree, const char *key)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_sbtree_delete_len(tree, key, strlen(key)));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_delete_len(c_sbtree_t *tree, const void *key, size_t len)
+{
+  __c_sbtree_node_t *root;
+
+  if(!tree || !key || !tree->root)
+    return(FALSE);
+
+  root = (__c_sbtree_node_t *)tree->root;
+
+  if(__C_sbtree_delete_node(tree, root, key, len) == __C_SBTREE_NOTFOUND)
+    return(FALSE);
+
+  --tree->size;
+
+  /* the root is exempt from the minimum fill; shrink the tree when it
+     empties */
+
+  if(root->count == 0)
+  {
+    tree->root = root->leaf ? NULL : root->slots[0];
+    C_free(root);
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_iterate(c_sbtree_t *tree,
+                          c_bool_t (*consumer)(const char *key, size_t len,
+                                               void *data, void *hook),
+                          void *hook)
+{
+  __c_sbtree_node_t *node;
+  uint_t i;
+
+  if(!tree || !consumer)
+    return(FALSE);
+
+  /* visit the leaves in key order, along their sibling links */
+
+  for(node = __C_sbtree_edge_leaf(tree, FALSE); node; node = node->next)
+  {
+    for(i = 0; i < node->count; ++i)
+    {
+      if(! consumer(node->keys[i], node->lens[i], node->slots[i], hook))
+        return(FALSE);
+    }
+  }
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_init(c_sbtree_t *tree, c_sbtree_cursor_t *cursor)
+{
+  if(!tree || !cursor)
+    return(FALSE);
+
+  cursor->tree = tree;
+  cursor->node = NULL;
+  cursor->pos = 0;
+  cursor->limit = NULL;
+  cursor->limitlen = 0;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_set_limit(c_sbtree_cursor_t *cursor,
+                                   const void *limit, size_t len)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->limit = limit;
+  cursor->limitlen = len;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_seek(c_sbtree_cursor_t *cursor, const char *key)
+{
+  if(!key)
+    return(FALSE);
+
+  return(C_sbtree_cursor_seek_len(cursor, key, strlen(key)));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_seek_len(c_sbtree_cursor_t *cursor, const void *key,
+                                  size_t len)
+{
+  __c_sbtree_node_t *node;
+
+  if(!cursor || !key)
+    return(FALSE);
+
+  if((node = __C_sbtree_find_leaf(cursor->tree, key, len)))
+    cursor->pos = __C_sbtree_search(cursor->tree, node, key, len);
+
+  cursor->node = node;
+
+  return(__C_sbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_first(c_sbtree_cursor_t *cursor)
+{
+  if(!cursor)
+    return(FALSE);
+
+  cursor->node = __C_sbtree_edge_leaf(cursor->tree, FALSE);
+  cursor->pos = 0;
+
+  return(__C_sbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_last(c_sbtree_cursor_t *cursor)
+{
+  __c_sbtree_node_t *node;
+  const void *limit;
+
+  if(!cursor)
+    return(FALSE);
+
+  /* With a limit, the last element is the one before the first element
+     at or beyond the limit; if there is no such element, or no limit, it
+     is the last element in the tree. */
+
+  if((limit = cursor->limit))
+  {
+    cursor->limit = NULL;
+
+    if(C_sbtree_cursor_seek_len(cursor, limit, cursor->limitlen))
+    {
+      cursor->limit = limit;
+      return(C_sbtree_cursor_prev(cursor));
+    }
+
+    cursor->limit = limit;
+  }
+
+  if(!(node = __C_sbtree_edge_leaf(cursor->tree, TRUE)))
+    return(FALSE);
+
+  cursor->node = node;
+  cursor->pos = node->count;
+
+  return(C_sbtree_cursor_prev(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_next(c_sbtree_cursor_t *cursor)
+{
+  if(!cursor || !cursor->node)
+    return(FALSE);
+
+  ++cursor->pos;
+
+  return(__C_sbtree_cursor_check(cursor));
+}
+
+/*
+ */
+
+c_bool_t C_sbtree_cursor_prev(c_sbtree_cursor_t *cursor)
+{
+  __c_sbtree_node_t *node;
+
+  if(!cursor)
+    return(FALSE);
+
+  for(node = (__c_sbtree_node_t *)cursor->node; node; node = node->prev)
+  {
+    if(cursor->pos > 0)
+    {
+      --cursor->pos;
+      cursor->node = node;
+      return(TRUE);
+    }
+
+    if(node->prev)
+      cursor->pos = node->prev->count;
+  }
+
+  cursor->node = NULL;
+
+  return(FALSE);
+}
+
+/*
+ */
+
+const char *C_sbtree_cursor_key(c_sbtree_cursor_t *cursor, size_t *len)
+{
+  __c_sbtree_node_t *node;
+
+  if(!cursor || !(node = (__c_sbtree_node_t *)cursor->node))
+    return(NULL);
+
+  if(len)
+    *len = node->lens[cursor->pos];
+
+  return(node->keys[cursor->pos]);
+}
+
+/*
+ */
+
+void *C_sbtree_cursor_value(c_sbtree_cursor_t *cursor)
+{
+  __c_sbtree_node_t *node;
+
+  if(!cursor || !(node = (__c_sbtree_node_t *)cursor->node))
+    return(NULL);
+
+  return(node->slots[cursor->pos]);
+}
+
+/* end of source file */
@@ -39,6 +39,69 @@
 
 #define C_STRING_BLOCKSZ 40
 
+/* Constants for C_string_hash64_len(). The algorithm is derived from
+   wyhash by Wang Yi, which is in the public domain. */
+
+#define __C_STRING_HASH_P0 0x2d358dccaa6c78a5ULL
+#define __C_STRING_HASH_P1 0x8bb84b93962eacc9ULL
+#define __C_STRING_HASH_P2 0x4b33a62ed433d4a3ULL
+#define __C_STRING_HASH_P3 0x4d5a2da51de1aa47ULL
+
+/* File scope functions */
+
+static inline uint64_t __C_string_read64(const c_byte_t *p)
+{
+  uint64_t v;
+
+  memcpy(&v, p, sizeof(v));
+  return(v);
+}
+
+/*
+ */
+
+static inline uint64_t __C_string_read32(const c_byte_t *p)
+{
+  uint32_t v;
+
+  memcpy(&v, p, sizeof(v));
+  return(v);
+}
+
+/*
+ */
+
+static inline void __C_string_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = *a;
+
+  r *= *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = (t < rl), lo, hi;
+
+  lo = t + (rm1 << 32);
+  c += (lo < t);
+  hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  *a = lo;
+  *b = hi;
+#endif
+}
+
+/*
+ */
+
+static inline uint64_t __C_string_mix(uint64_t a, uint64_t b)
+{
+  __C_string_mum(&a, &b);
+
+  return(a ^ b);
+}
+
 /* Functions */
 
 char *C_string_clean(char *s, char fillc)
@@ -560,6 +623,94 @@ uint_t C_string_hash(const char *s, uint_t modulo)
   return(hashval % modulo);
 }
 
+/*
+ */
+
+uint64_t C_string_hash64_len(const void *s, size_t len, uint64_t seed)
+{
+  const c_byte_t *p = (const c_byte_t *)s;
+  uint64_t a, b, see1, see2;
+  size_t i;
+
+  if(!s)
+    return(0);
+
+  seed ^= __C_string_mix(seed ^ __C_STRING_HASH_P0, __C_STRING_HASH_P1);
+
+  if(len <= 16)
+  {
+    if(len >= 4)
+    {
+      a = (__C_string_read32(p) << 32)
+        | __C_string_read32(p + ((len >> 3) << 2));
+      b = (__C_string_read32(p + len - 4) << 32)
+        | __C_string_read32(p + len - 4 - ((len >> 3) << 2));
+    }
+    else if(len > 0)
+    {
+      a = (((uint64_t)p[0]) << 16) | (((uint64_t)p[len >> 1]) << 8)
+        | p[len - 1];
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else
+  {
+    /* consume the input 48 bytes at a time in three independent lanes,
+       then 16 bytes at a time */
+
+    i = len;
+    if(i > 48)
+    {
+      see1 = see2 = seed;
+
+      do
+      {
+        seed = __C_string_mix(__C_string_read64(p) ^ __C_STRING_HASH_P1,
+                              __C_string_read64(p + 8) ^ seed);
+        see1 = __C_string_mix(__C_string_read64(p + 16) ^ __C_STRING_HASH_P2,
+                              __C_string_read64(p + 24) ^ see1);
+        see2 = __C_string_mix(__C_string_read64(p + 32) ^ __C_STRING_HASH_P3,
+                              __C_string_read64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      }
+      while(i > 48);
+
+      seed ^= see1 ^ see2;
+    }
+
+    while(i > 16)
+    {
+      seed = __C_string_mix(__C_string_read64(p) ^ __C_STRING_HASH_P1,
+                            __C_string_read64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+
+    a = __C_string_read64(p + i - 16);
+    b = __C_string_read64(p + i - 8);
+  }
+
+  a ^= __C_STRING_HASH_P1;
+  b ^= seed;
+  __C_string_mum(&a, &b);
+
+  return(__C_string_mix(a ^ __C_STRING_HASH_P0 ^ len, b ^ __C_STRING_HASH_P1));
+}
+
+/*
+ */
+
+uint64_t C_string_hash64(const char *s, uint64_t seed)
+{
+  if(!s)
+    return(0);
+
+  return(C_string_hash64_len(s, strlen(s), seed));
+}
+
 /*
  */
 
@@ -0,0 +1,363 @@
+/* ----------------------------------------------------------------------------
+   cbase - A C Foundation Library
+   Copyright (C) 1994-2025  Mark A Lindner
+
+   This file is part of cbase.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, see
+   <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------------
+*/
+
+/* A stress test and benchmark for concurrent b-trees. A number of writer
+   threads and reader threads operate on one tree at once, and the
+   results are checked against what the writers know they have stored.
+
+   Each writer owns the keys congruent to its id modulo the number of
+   writers, and uses them in two ways. Odd keys are "permanent": they are
+   stored in ascending order and never deleted, and the number stored so
+   far is published to the readers, which must then always find them.
+   Even keys are "churn" keys, which are stored and deleted at random, so
+   that nodes are split and emptied while readers descend through them;
+   a reader that finds one must see a value that belongs to that key.
+   When all threads have finished, the tree is checked element by
+   element against the writers' records.
+
+   Usage: cbtree-stress [-w writers] [-r readers] [-n ops] [-o order]
+*/
+
+/* Feature test switches */
+
+#include "config.h"
+
+/* System headers */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+/* Local headers */
+
+#include "cbase/cbase.h"
+
+/* Macros */
+
+#define DEFAULT_WRITERS 4
+#define DEFAULT_READERS 4
+#define DEFAULT_OPS 200000
+#define DEFAULT_ORDER 8
+
+#define CHURN_KEYS 4096
+
+/* a value records its key and a generation number, so that a reader can
+   tell whether a value it found belongs to the key it looked up */
+
+#define PERMANENT_KEY(W, I) ((c_id_t)(((I) * nwriters + (W)) * 2 + 1))
+#define CHURN_KEY(W, J) ((c_id_t)(((J) * nwriters + (W)) * 2 + 2))
+
+#define MAKE_VALUE(K, G) ((void *)(uintptr_t)(((K) << 8) | ((G) & 0xFF)))
+#define VALUE_KEY(V) ((c_id_t)((uintptr_t)(V) >> 8))
+
+typedef struct writer_t
+{
+  pthread_t thread;
+  uint_t id;
+  uint_t published;
+  uint_t gens[CHURN_KEYS];
+  unsigned int seed;
+  long errors;
+} writer_t;
+
+typedef struct reader_t
+{
+  pthread_t thread;
+  unsigned int seed;
+  long lookups;
+  long errors;
+} reader_t;
+
+typedef struct check_t
+{
+  c_id_t last;
+  size_t count;
+  long errors;
+} check_t;
+
+/* File scope variables */
+
+static c_cbtree_t *tree;
+static writer_t *writers;
+static uint_t nwriters = DEFAULT_WRITERS;
+static uint_t nreaders = DEFAULT_READERS;
+static long nops = DEFAULT_OPS;
+static int done = FALSE;
+
+/* File scope functions */
+
+static double now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+
+  return((double)tv.tv_sec + ((double)tv.tv_usec / 1e6));
+}
+
+/*
+ */
+
+static void *writer_main(void *arg)
+{
+  writer_t *w = (writer_t *)arg;
+  c_id_t key;
+  uint_t i = 0, j;
+  long op;
+
+  for(op = 0; op < nops; ++op)
+  {
+    if((rand_r(&(w->seed)) % 4) == 0)
+    {
+      key = PERMANENT_KEY(w->id, i);
+      if(! C_cbtree_store(tree, key, MAKE_VALUE(key, 0)))
+        ++w->errors;
+
+      __atomic_store_n(&(w->published), ++i, __ATOMIC_RELEASE);
+    }
+    else
+    {
+      j = rand_r(&(w->seed)) % CHURN_KEYS;
+      key = CHURN_KEY(w->id, j);
+
+      if(w->gens[j] == 0)
+      {
+        w->gens[j] = 1 + (rand_r(&(w->seed)) % 255);
+        if(! C_cbtree_store(tree, key, MAKE_VALUE(key, w->gens[j])))
+          ++w->errors;
+      }
+      else
+      {
+        if(! C_cbtree_delete(tree, key))
+          ++w->errors;
+        w->gens[j] = 0;
+      }
+    }
+  }
+
+  return(NULL);
+}
+
+/*
+ */
+
+static void *reader_main(void *arg)
+{
+  reader_t *r = (reader_t *)arg;
+  writer_t *w;
+  c_id_t key;
+  uint_t n;
+  void *v;
+
+  /* read until all writers have finished, and at least nops times */
+
+  for(;;)
+  {
+    w = &(writers[rand_r(&(r->seed)) % nwriters]);
+
+    if(rand_r(&(r->seed)) % 2)
+    {
+      n = __atomic_load_n(&(w->published), __ATOMIC_ACQUIRE);
+      if(n == 0)
+        continue;
+
+      key = PERMANENT_KEY(w->id, rand_r(&(r->seed)) % n);
+      if(C_cbtree_restore(tree, key) != MAKE_VALUE(key, 0))
+        ++r->errors;
+    }
+    else
+    {
+      key = CHURN_KEY(w->id, rand_r(&(r->seed)) % CHURN_KEYS);
+      v = C_cbtree_restore(tree, key);
+      if(v && (VALUE_KEY(v) != key))
+        ++r->errors;
+    }
+
+    if((++r->lookups >= nops) && __atomic_load_n(&done, __ATOMIC_ACQUIRE))
+      break;
+  }
+
+  return(NULL);
+}
+
+/*
+ */
+
+static c_bool_t check_element(c_id_t key, void *data, void *hook)
+{
+  check_t *c = (check_t *)hook;
+
+  if(((c->count > 0) && (key <= c->last)) || (VALUE_KEY(data) != key))
+    ++c->errors;
+
+  c->last = key;
+  ++c->count;
+
+  return(TRUE);
+}
+
+/*
+ */
+
+static long check_tree(void)
+{
+  writer_t *w;
+  check_t c = { 0, 0, 0 };
+  size_t expected = 0;
+  c_id_t key;
+  uint_t i, j;
+  void *v;
+
+  for(w = writers; w < writers + nwriters; ++w)
+  {
+    for(i = 0; i < w->published; ++i, ++expected)
+    {
+      key = PERMANENT_KEY(w->id, i);
+      if(C_cbtree_restore(tree, key) != MAKE_VALUE(key, 0))
+        ++c.errors;
+    }
+
+    for(j = 0; j < CHURN_KEYS; ++j)
+    {
+      key = CHURN_KEY(w->id, j);
+      v = C_cbtree_restore(tree, key);
+
+      if(w->gens[j])
+      {
+        ++expected;
+        if(v != MAKE_VALUE(key, w->gens[j]))
+          ++c.errors;
+      }
+      else if(v)
+        ++c.errors;
+    }
+  }
+
+  C_cbtree_iterate(tree, check_element, &c);
+
+  if((c.count != expected) || (C_cbtree_size(tree) != expected))
+    ++c.errors;
+
+  return(c.errors);
+}
+
+/* Functions */
+
+int main(int argc, char **argv)
+{
+  reader_t *readers;
+  uint_t order = DEFAULT_ORDER, i;
+  long errors = 0, lookups = 0;
+  double start, wdone, rdone;
+  int ch;
+
+  while((ch = getopt(argc, argv, "w:r:n:o:")) != EOF)
+  {
+    switch(ch)
+    {
+      case 'w':
+        nwriters = (uint_t)atoi(optarg);
+        break;
+
+      case 'r':
+        nreaders = (uint_t)atoi(optarg);
+        break;
+
+      case 'n':
+        nops = atol(optarg);
+        break;
+
+      case 'o':
+        order = (uint_t)atoi(optarg);
+        break;
+
+      default:
+        fprintf(stderr, "usage: %s [-w writers] [-r readers] [-n ops] "
+                "[-o order]\n", argv[0]);
+        return(2);
+    }
+  }
+
+  if((nwriters < 1) || (nops < 1) || ! (tree = C_cbtree_create(order)))
+  {
+    fprintf(stderr, "%s: invalid arguments\n", argv[0]);
+    return(2);
+  }
+
+  writers = C_newa(nwriters, writer_t);
+  readers = C_newa(nreaders ? nreaders : 1, reader_t);
+
+  start = now();
+
+  for(i = 0; i < nwriters; ++i)
+  {
+    writers[i].id = i;
+    writers[i].seed = 1 + i;
+    pthread_create(&(writers[i].thread), NULL, writer_main, &(writers[i]));
+  }
+
+  for(i = 0; i < nreaders; ++i)
+  {
+    readers[i].seed = 1001 + i;
+    pthread_create(&(readers[i].thread), NULL, reader_main, &(readers[i]));
+  }
+
+  for(i = 0; i < nwriters; ++i)
+  {
+    pthread_join(writers[i].thread, NULL);
+    errors += writers[i].errors;
+  }
+
+  wdone = now();
+
+  /* the readers keep reading until the writers are done */
+
+  __atomic_store_n(&done, TRUE, __ATOMIC_RELEASE);
+
+  for(i = 0; i < nreaders; ++i)
+  {
+    pthread_join(readers[i].thread, NULL);
+    errors += readers[i].errors;
+    lookups += readers[i].lookups;
+  }
+
+  rdone = now();
+
+  errors += check_tree();
+
+  printf("order %u, %u writers x %ld ops: %.0f updates/s\n", order,
+         nwriters, nops, ((double)nwriters * (double)nops) / (wdone - start));
+  printf("%u readers, %ld lookups: %.0f lookups/s\n", nreaders, lookups,
+         (double)lookups / (rdone - start));
+  printf("%zu elements, %ld errors\n", C_cbtree_size(tree), errors);
+
+  C_cbtree_destroy(tree);
+  C_free(writers);
+  C_free(readers);
+
+  return(errors ? 1 : 0);
+}
+
+/* end of source file */